@@ -253,6 +253,8 @@ public:
 
     // all code accesses are forced nonseq 32bit
     u32 CodeRead32(u32 addr, bool branch);
+    // how long CodeRead32 takes with the given region timing, without fetching anything
+    u32 CodeFetchCycles(u32 addr, bool branch, u32 regionCodeCycles) const;
 
     void DataRead8(u32 addr, u32* val) override;
     void DataRead16(u32 addr, u32* val) override;
@@ -234,6 +234,12 @@ ARMJIT::~ARMJIT() noexcept
 {
     JitEnableWrite();
     ResetBlockCache();
+
+    StopCompileThread();
+    Platform::Semaphore_Free(Sema_CompileStart);
+    Platform::Semaphore_Free(Sema_CompileDone);
+    Platform::Mutex_Free(CompileJobsLock);
+    Platform::Mutex_Free(CompilerLock);
 }
 
 void ARMJIT::Reset() noexcept
@@ -262,8 +268,9 @@ void FloodFillSetFlags(FetchedInstr instrs[], int start, u8 flags)
     }
 }
 
-bool DecodeLiteral(bool thumb, const FetchedInstr& instr, u32& addr)
+bool DecodeLiteral(bool thumb, const FetchedInstr& instr, u32& addr, int& size, bool& signExtend)
 {
+    signExtend = false;
     if (!thumb)
     {
         switch (instr.Info.Kind)
@@ -271,9 +278,14 @@ bool DecodeLiteral(bool thumb, const FetchedInstr& instr, u32& addr)
         case ARMInstrInfo::ak_LDR_IMM:
         case ARMInstrInfo::ak_LDRB_IMM:
             addr = (instr.Addr + 8) + ((instr.Instr & 0xFFF) * (instr.Instr & (1 << 23) ? 1 : -1));
+            size = instr.Info.Kind == ARMInstrInfo::ak_LDR_IMM ? 32 : 8;
             return true;
         case ARMInstrInfo::ak_LDRH_IMM:
+        case ARMInstrInfo::ak_LDRSB_IMM:
+        case ARMInstrInfo::ak_LDRSH_IMM:
             addr = (instr.Addr + 8) + (((instr.Instr & 0xF00) >> 4 | (instr.Instr & 0xF)) * (instr.Instr & (1 << 23) ? 1 : -1));
+            size = instr.Info.Kind == ARMInstrInfo::ak_LDRSB_IMM ? 8 : 16;
+            signExtend = instr.Info.Kind != ARMInstrInfo::ak_LDRH_IMM;
             return true;
         default:
             break;
@@ -282,6 +294,7 @@ bool DecodeLiteral(bool thumb, const FetchedInstr& instr, u32& addr)
     else if (instr.Info.Kind == ARMInstrInfo::tk_LDR_PCREL)
     {
         addr = ((instr.Addr + 4) & ~0x2) + ((instr.Instr & 0xFF) << 2);
+        size = 32;
         return true;
     }
 
@@ -289,6 +302,53 @@ bool DecodeLiteral(bool thumb, const FetchedInstr& instr, u32& addr)
     return false;
 }
 
+void ARMJIT::SnapshotLiteral(ARM* cpu, bool thumb, FetchedInstr& instr) noexcept
+{
+    // these are the literal loads the compiler inlines: LDR PC relative and
+    // pre-indexed immediate loads from r15 without writeback
+    instr.LiteralValid = false;
+    if (!LiteralOptimizations || instr.Info.SpecialKind != ARMInstrInfo::special_LoadLiteral)
+        return;
+
+    if (!thumb && (instr.A_Reg(12) == 15 || instr.Instr & (1 << 21)))
+        return;
+
+    u32 addr;
+    int size;
+    bool signExtend;
+    if (!DecodeLiteral(thumb, instr, addr, size, signExtend))
+        return;
+
+    if (InvalidLiterals.Find(LocaliseCodeAddress(cpu->Num, addr)) != -1)
+        return;
+
+    u32 val;
+    // make sure arm7 bios is accessible
+    u32 tmpR15 = cpu->R[15];
+    cpu->R[15] = instr.Addr + (thumb ? 4 : 8);
+    if (size == 32)
+    {
+        cpu->DataRead32(addr & ~0x3, &val);
+        val = melonDS::ROR(val, (addr & 0x3) << 3);
+    }
+    else if (size == 16)
+    {
+        cpu->DataRead16(addr & ~0x1, &val);
+        if (signExtend)
+            val = ((s32)val << 16) >> 16;
+    }
+    else
+    {
+        cpu->DataRead8(addr, &val);
+        if (signExtend)
+            val = ((s32)val << 24) >> 24;
+    }
+    cpu->R[15] = tmpR15;
+
+    instr.LiteralValue = val;
+    instr.LiteralValid = true;
+}
+
 bool DecodeBranch(bool thumb, const FetchedInstr& instr, u32& cond, bool hasLink, u32 lr, bool& link,
     u32& linkAddr, u32& targetAddr)
 {
@@ -475,15 +535,173 @@ ARMJIT::ARMJIT(melonDS::NDS& nds, std::optional<JITArgs> jit) noexcept :
         MaxBlockSize(jit.has_value() ? std::clamp(jit->MaxBlockSize, 1u, 32u) : 32),
         LiteralOptimizations(jit.has_value() ? jit->LiteralOptimizations : false),
         BranchOptimizations(jit.has_value() ? jit->BranchOptimizations : false),
-        FastMemory((jit.has_value() ? jit->FastMemory : false) && ARMJIT_Memory::IsFastMemSupported())
-{}
+        FastMemory((jit.has_value() ? jit->FastMemory : false) && ARMJIT_Memory::IsFastMemSupported()),
+        CompileThreshold(jit.has_value() ? std::max(jit->CompileThreshold, 1u) : 1),
+        CompileBudget(jit.has_value() ? jit->CompileBudget : 0),
+        BackgroundCompile((jit.has_value() ? jit->BackgroundCompile : false) && Compiler::SupportsBackgroundCompile)
+{
+    CompilerLock = Platform::Mutex_Create();
+    CompileJobsLock = Platform::Mutex_Create();
+    Sema_CompileStart = Platform::Semaphore_Create();
+    Sema_CompileDone = Platform::Semaphore_Create();
+
+    if (BackgroundCompile)
+        StartCompileThread();
+}
+
+void ARMJIT::StartCompileThread() noexcept
+{
+    if (CompileThread)
+        return;
+
+    Platform::Semaphore_Reset(Sema_CompileStart);
+    Platform::Semaphore_Reset(Sema_CompileDone);
+    CompileThreadRunning = true;
+    CompileThread = Platform::Thread_Create([this]() { CompileThreadFunc(); });
+}
+
+void ARMJIT::StopCompileThread() noexcept
+{
+    if (!CompileThread)
+        return;
+
+    // the thread finishes whatever it's working on first
+    CompileThreadRunning = false;
+    Platform::Semaphore_Post(Sema_CompileStart);
+
+    Platform::Thread_Wait(CompileThread);
+    Platform::Thread_Free(CompileThread);
+    CompileThread = nullptr;
+}
+
+void ARMJIT::CompileThreadFunc() noexcept
+{
+    for (;;)
+    {
+        Platform::Semaphore_Wait(Sema_CompileStart);
+        if (!CompileThreadRunning) return;
+
+        // jobs are taken in the order they were queued, so which blocks
+        // fit into the current code zone doesn't depend on timing
+        Platform::Mutex_Lock(CompileJobsLock);
+        CompileJob* job = CompileJobs[CompileJobsDone].get();
+        Platform::Mutex_Unlock(CompileJobsLock);
+
+        // recycling a zone changes the block maps, so that's left to the emulation thread
+        job->EntryPoint = NULL;
+        Platform::Mutex_Lock(CompilerLock);
+        if (!JITCompiler.CodeZoneFull())
+        {
+            JitEnableWrite();
+            job->EntryPoint = JITCompiler.CompileBlock(job->CPU, job->Thumb, job->Instrs, job->InstrsCount, job->HasMemoryInstr);
+            JitEnableExecute();
+        }
+        Platform::Mutex_Unlock(CompilerLock);
+
+        Platform::Mutex_Lock(CompileJobsLock);
+        CompileJobsDone++;
+        Platform::Mutex_Unlock(CompileJobsLock);
+        Platform::Semaphore_Post(Sema_CompileDone);
+    }
+}
+
+void ARMJIT::QueueCompileJob(ARM* cpu, bool thumb, FetchedInstr instrs[], int instrsCount, bool hasMemoryInstr, JitBlock* block) noexcept
+{
+    auto job = std::make_unique<CompileJob>();
+    job->Block = block;
+    job->CPU = cpu;
+    job->Thumb = thumb;
+    job->HasMemoryInstr = hasMemoryInstr;
+    job->InstrsCount = instrsCount;
+    memcpy(job->Instrs, instrs, instrsCount * sizeof(FetchedInstr));
+    job->EntryPoint = NULL;
+
+    PendingBlocks[BlockKey(cpu->Num, block->StartAddrLocal)] = job.get();
+
+    Platform::Mutex_Lock(CompileJobsLock);
+    CompileJobs.push_back(std::move(job));
+    Platform::Mutex_Unlock(CompileJobsLock);
+    Platform::Semaphore_Post(Sema_CompileStart);
+}
+
+void ARMJIT::WaitForCompileThread() noexcept
+{
+    // only the emulation thread adds jobs
+    if (CompileJobs.empty())
+        return;
+
+    for (;;)
+    {
+        Platform::Mutex_Lock(CompileJobsLock);
+        bool done = CompileJobsDone == CompileJobs.size();
+        Platform::Mutex_Unlock(CompileJobsLock);
+        if (done)
+            break;
+
+        Platform::Semaphore_Wait(Sema_CompileDone);
+    }
+    Platform::Semaphore_Reset(Sema_CompileDone);
+}
+
+void ARMJIT::InstallCompiledBlocks() noexcept
+{
+    WaitForCompileThread();
+
+    for (auto& job : CompileJobs)
+    {
+        JitBlock* block = job->Block;
+        if (!block)
+            continue;
+
+        PendingBlocks.erase(BlockKey(block->Num, block->StartAddrLocal));
+
+        if (!job->EntryPoint)
+        {
+            // there was no space left, it's compiled again when it's reached next
+            UnlinkJitBlock(block);
+            BlockArena.Free(block);
+            continue;
+        }
+
+        block->EntryPoint = job->EntryPoint;
+        Stats.BlocksCompiled++;
+
+        JitBlockDirectory& blocks = block->Num == 0 ? JitBlocks9 : JitBlocks7;
+        blocks.Insert(block);
+
+        u64* entry = &FastBlockLookupRegions[block->StartAddrLocal >> 27][(block->StartAddrLocal & 0x7FFFFFF) / 2];
+        *entry = ((u64)block->StartAddr | block->Num) << 32;
+        *entry |= JITCompiler.SubEntryOffset(block->EntryPoint);
+    }
+
+    CompileJobs.clear();
+    CompileJobsDone = 0;
+    assert(PendingBlocks.empty());
+
+    if (JITCompiler.CodeZoneFull())
+    {
+        JitEnableWrite();
+        RecycleCodeZone();
+        JitEnableExecute();
+    }
+}
+
+void ARMJIT::BeginFrame() noexcept
+{
+    CompiledThisFrame = 0;
+
+    // the start of a frame is a fixed point in emulated time, so blocks
+    // start being used at the same moment on every run
+    if (!CompileJobs.empty())
+        InstallCompiledBlocks();
+}
 
 void ARMJIT::RetireJitBlock(JitBlock* block) noexcept
 {
     auto it = RestoreCandidates.find(block->InstrHash);
     if (it != RestoreCandidates.end())
     {
-        delete it->second;
+        BlockArena.Free(it->second);
         it->second = block;
     }
     else
@@ -492,41 +710,70 @@ void ARMJIT::RetireJitBlock(JitBlock* block) noexcept
     }
 }
 
+bool ARMJIT::DeferCompilation(u32 num, u32 blockAddr) noexcept
+{
+    if (CompileThreshold <= 1 && CompileBudget == 0)
+        return false;
+
+    // code which only runs once or twice is cheaper to interpret than to compile,
+    // the budget spreads the cost of compiling newly reached code over several frames.
+    // Most entries are for code which never gets hot, so they're dropped now and then
+    if (DeferredBlocks.size() >= MaxDeferredBlocks)
+        DeferredBlocks.clear();
+    auto it = DeferredBlocks.try_emplace(BlockKey(num, blockAddr), 0).first;
+    it->second++;
+    if (it->second < CompileThreshold || (CompileBudget && CompiledThisFrame >= CompileBudget))
+        return true;
+
+    DeferredBlocks.erase(it);
+    return false;
+}
+
 void ARMJIT::SetJITArgs(JITArgs args) noexcept
 {
     args.FastMemory = args.FastMemory && ARMJIT_Memory::IsFastMemSupported();
     args.MaxBlockSize = std::clamp(args.MaxBlockSize, 1u, 32u);
+    args.BackgroundCompile = args.BackgroundCompile && Compiler::SupportsBackgroundCompile;
 
     if (MaxBlockSize != args.MaxBlockSize
         || LiteralOptimizations != args.LiteralOptimizations
         || BranchOptimizations != args.BranchOptimizations
-        || FastMemory != args.FastMemory)
+        || FastMemory != args.FastMemory
+        || BackgroundCompile != args.BackgroundCompile)
         ResetBlockCache();
 
     MaxBlockSize = args.MaxBlockSize;
     LiteralOptimizations = args.LiteralOptimizations;
     BranchOptimizations = args.BranchOptimizations;
     FastMemory = args.FastMemory;
+    CompileThreshold = std::max(args.CompileThreshold, 1u);
+    CompileBudget = args.CompileBudget;
+    BackgroundCompile = args.BackgroundCompile;
+
+    if (BackgroundCompile)
+        StartCompileThread();
+    else
+        StopCompileThread();
 }
 
 void ARMJIT::SetMaxBlockSize(int size) noexcept
 {
-    SetJITArgs(JITArgs{static_cast<unsigned>(size), LiteralOptimizations, LiteralOptimizations, FastMemory});
+    SetJITArgs(JITArgs{static_cast<unsigned>(size), LiteralOptimizations, LiteralOptimizations, FastMemory, CompileThreshold, CompileBudget, BackgroundCompile});
 }
 
 void ARMJIT::SetLiteralOptimizations(bool enabled) noexcept
 {
-    SetJITArgs(JITArgs{static_cast<unsigned>(MaxBlockSize), enabled, BranchOptimizations, FastMemory});
+    SetJITArgs(JITArgs{static_cast<unsigned>(MaxBlockSize), enabled, BranchOptimizations, FastMemory, CompileThreshold, CompileBudget, BackgroundCompile});
 }
 
 void ARMJIT::SetBranchOptimizations(bool enabled) noexcept
 {
-    SetJITArgs(JITArgs{static_cast<unsigned>(MaxBlockSize), LiteralOptimizations, enabled, FastMemory});
+    SetJITArgs(JITArgs{static_cast<unsigned>(MaxBlockSize), LiteralOptimizations, enabled, FastMemory, CompileThreshold, CompileBudget, BackgroundCompile});
 }
 
 void ARMJIT::SetFastMemory(bool enabled) noexcept
 {
-    SetJITArgs(JITArgs{static_cast<unsigned>(MaxBlockSize), LiteralOptimizations, BranchOptimizations, enabled});
+    SetJITArgs(JITArgs{static_cast<unsigned>(MaxBlockSize), LiteralOptimizations, BranchOptimizations, enabled, CompileThreshold, CompileBudget, BackgroundCompile});
 }
 
 void ARMJIT::CompileBlock(ARM* cpu) noexcept
@@ -541,29 +788,50 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
         Log(LogLevel::Warn, "trying to compile non executable code? %x\n", blockAddr);
     }
 
-    auto& map = cpu->Num == 0 ? JitBlocks9 : JitBlocks7;
-    auto existingBlockIt = map.find(blockAddr);
-    if (existingBlockIt != map.end())
+    // blocks are kept by their local address, so one compiled before some memory
+    // was remapped stays around for when the old mapping comes back
+    JitBlockDirectory& blocks = cpu->Num == 0 ? JitBlocks9 : JitBlocks7;
+    if (JitBlock* existingBlock = blocks.Find(localAddr, blockAddr))
     {
         // there's already a block, though it's not inside the fast map
         // could be that there are two blocks at the same physical addr
         // but different mirrors
-        u32 otherLocalAddr = existingBlockIt->second->StartAddrLocal;
+        JIT_DEBUGPRINT("switching out block %x %x %x\n", localAddr, blockAddr, existingBlock->StartAddr);
 
-        if (localAddr == otherLocalAddr)
-        {
-            JIT_DEBUGPRINT("switching out block %x %x %x\n", localAddr, blockAddr, existingBlockIt->second->StartAddr);
+        u64* entry = &FastBlockLookupRegions[localAddr >> 27][(localAddr & 0x7FFFFFF) / 2];
+        *entry = ((u64)blockAddr | cpu->Num) << 32;
+        *entry |= JITCompiler.SubEntryOffset(existingBlock->EntryPoint);
+        return;
+    }
 
-            u64* entry = &FastBlockLookupRegions[localAddr >> 27][(localAddr & 0x7FFFFFF) / 2];
-            *entry = ((u64)blockAddr | cpu->Num) << 32;
-            *entry |= JITCompiler.SubEntryOffset(existingBlockIt->second->EntryPoint);
-            return;
+    // literals which were overwritten during an earlier session are
+    // treated as invalid right away instead of only after the first invalidation
+    u32 seededLiterals[MaxBlockSize];
+    u32 numSeededLiterals = 0;
+    auto persistentIt = PersistentBlocks.find(BlockKey(cpu->Num, blockAddr));
+    if (persistentIt != PersistentBlocks.end())
+    {
+        for (u32 addr : persistentIt->second.VolatileLiterals)
+        {
+            if (numSeededLiterals < MaxBlockSize && InvalidLiterals.Find(addr) == -1)
+            {
+                InvalidLiterals.Add(addr);
+                seededLiterals[numSeededLiterals++] = addr;
+            }
         }
-
-        // some memory has been remapped
-        RetireJitBlock(existingBlockIt->second);
-        map.erase(existingBlockIt);
     }
+    auto forgetStalePersistentBlock = [&](u32 instrHash)
+    {
+        if (persistentIt != PersistentBlocks.end() && persistentIt->second.InstrHash != instrHash)
+        {
+            // the code here isn't the one we remember anymore. Whatever
+            // got compiled doesn't depend on the seeded literals, so they can go
+            for (u32 j = 0; j < numSeededLiterals; j++)
+                InvalidLiterals.RemoveByValue(seededLiterals[j]);
+            PersistentBlocks.erase(persistentIt);
+            PersistentBlocksDirty = true;
+        }
+    };
 
     FetchedInstr instrs[MaxBlockSize];
     int i = 0;
@@ -699,11 +967,16 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
 
         instrs[i].DataCycles = cpu->DataCycles;
         instrs[i].DataRegion = cpu->DataRegion;
+        instrs[i].DataMemRegion = cpu->Num == 0
+            ? Memory.ClassifyAddress9(cpu->DataRegion)
+            : Memory.ClassifyAddress7(cpu->DataRegion);
 
         u32 literalAddr;
+        int literalSize;
+        bool literalSignExtend;
         if (LiteralOptimizations
             && instrs[i].Info.SpecialKind == ARMInstrInfo::special_LoadLiteral
-            && DecodeLiteral(thumb, instrs[i], literalAddr))
+            && DecodeLiteral(thumb, instrs[i], literalAddr, literalSize, literalSignExtend))
         {
             u32 translatedAddr = LocaliseCodeAddress(cpu->Num, literalAddr);
             if (!translatedAddr)
@@ -722,7 +995,13 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
                     addressRanges[numAddressRanges++] = translatedAddrRounded;
                 addressMasks[j] |= 1 << ((translatedAddr & 0x1FF) / 16);
                 JIT_DEBUGPRINT("literal loading %08x %08x %08x %08x\n", literalAddr, translatedAddr, addressMasks[j], addressRanges[j]);
-                cpu->DataRead32(literalAddr, &literalValues[numLiterals]);
+                // only the bytes the load actually uses go into the literal hash
+                if (literalSize == 32)
+                    cpu->DataRead32(literalAddr & ~0x3, &literalValues[numLiterals]);
+                else if (literalSize == 16)
+                    cpu->DataRead16(literalAddr & ~0x1, &literalValues[numLiterals]);
+                else
+                    cpu->DataRead8(literalAddr, &literalValues[numLiterals]);
                 literalLoadAddrs[numLiterals++] = translatedAddr;
             }
         }
@@ -844,6 +1123,13 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
     u32 literalHash = (u32)XXH3_64bits(literalValues, numLiterals * 4);
     u32 instrHash = (u32)XXH3_64bits(instrValues, numInstrs * 4);
 
+    if (PendingBlocks.count(BlockKey(cpu->Num, localAddr)))
+    {
+        // it's still being compiled, until then it's interpreted
+        forgetStalePersistentBlock(instrHash);
+        return;
+    }
+
     auto prevBlockIt = RestoreCandidates.find(instrHash);
     JitBlock* prevBlock = NULL;
     bool mayRestore = true;
@@ -874,13 +1160,35 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
         mayRestore = false;
     }
 
+    if (!mayRestore && DeferCompilation(cpu->Num, blockAddr))
+    {
+        // the block has already been run through the interpreter above,
+        // so there's nothing left to do until it's reached again
+        if (prevBlock)
+            BlockArena.Free(prevBlock);
+        forgetStalePersistentBlock(instrHash);
+        return;
+    }
+
     JitBlock* block;
     if (!mayRestore)
     {
         if (prevBlock)
-            delete prevBlock;
+            BlockArena.Free(prevBlock);
+
+        CompiledThisFrame++;
+
+        JitEnableWrite();
+        // before the block is allocated, with a single zone this resets the whole cache.
+        // With the compile thread this is done once the finished blocks are installed
+        if (!BackgroundCompile && JITCompiler.CodeZoneFull())
+            RecycleCodeZone();
+
+        FloodFillSetFlags(instrs, i - 1, 0xF);
+        for (int j = 0; j < i; j++)
+            SnapshotLiteral(cpu, thumb, instrs[j]);
 
-        block = new JitBlock(cpu->Num, i, numAddressRanges, numLiterals);
+        block = BlockArena.Allocate(cpu->Num, numAddressRanges, numLiterals);
         block->LiteralHash = literalHash;
         block->InstrHash = instrHash;
         for (u32 j = 0; j < numAddressRanges; j++)
@@ -893,10 +1201,16 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
         block->StartAddr = blockAddr;
         block->StartAddrLocal = localAddr;
 
-        FloodFillSetFlags(instrs, i - 1, 0xF);
-
-        JitEnableWrite();
-        block->EntryPoint = JITCompiler.CompileBlock(cpu, thumb, instrs, i, hasMemoryInstr);
+        if (BackgroundCompile)
+        {
+            block->EntryPoint = NULL;
+            QueueCompileJob(cpu, thumb, instrs, i, hasMemoryInstr, block);
+        }
+        else
+        {
+            block->EntryPoint = JITCompiler.CompileBlock(cpu, thumb, instrs, i, hasMemoryInstr);
+            Stats.BlocksCompiled++;
+        }
         JitEnableExecute();
 
         JIT_DEBUGPRINT("block start %p\n", block->EntryPoint);
@@ -905,6 +1219,7 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
     {
         JIT_DEBUGPRINT("restored! %p\n", prevBlock);
         block = prevBlock;
+        Stats.BlocksRestored++;
     }
 
     assert((localAddr & 1) == 0);
@@ -924,14 +1239,20 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
         range->Blocks.Add(block);
     }
 
-    if (cpu->Num == 0)
-        JitBlocks9[blockAddr] = block;
-    else
-        JitBlocks7[blockAddr] = block;
+    // a queued block is only entered into the directory once it's installed
+    if (!block->EntryPoint)
+    {
+        forgetStalePersistentBlock(instrHash);
+        return;
+    }
+
+    blocks.Insert(block);
 
     u64* entry = &FastBlockLookupRegions[(localAddr >> 27)][(localAddr & 0x7FFFFFF) / 2];
     *entry = ((u64)blockAddr | cpu->Num) << 32;
     *entry |= JITCompiler.SubEntryOffset(block->EntryPoint);
+
+    forgetStalePersistentBlock(instrHash);
 }
 
 void ARMJIT::InvalidateByAddr(u32 localAddr) noexcept
@@ -986,6 +1307,18 @@ void ARMJIT::InvalidateByAddr(u32 localAddr) noexcept
                     JIT_DEBUGPRINT("found invalid literal %d\n", InvalidLiterals.Length);
                 }
                 literalInvalidation = true;
+
+                PersistentBlockInfo& info = PersistentBlocks[BlockKey(block->Num, block->StartAddr)];
+                if (info.InstrHash != block->InstrHash)
+                {
+                    info.InstrHash = block->InstrHash;
+                    info.VolatileLiterals.clear();
+                }
+                if (std::find(info.VolatileLiterals.begin(), info.VolatileLiterals.end(), localAddr) == info.VolatileLiterals.end())
+                {
+                    info.VolatileLiterals.push_back(localAddr);
+                    PersistentBlocksDirty = true;
+                }
                 break;
             }
         }
@@ -1011,11 +1344,24 @@ void ARMJIT::InvalidateByAddr(u32 localAddr) noexcept
             }
         }
 
+        if (!block->EntryPoint)
+        {
+            // still waiting to be compiled, whatever comes out of it is thrown away
+            auto pendingIt = PendingBlocks.find(BlockKey(block->Num, block->StartAddrLocal));
+            assert(pendingIt != PendingBlocks.end());
+            pendingIt->second->Block = NULL;
+            PendingBlocks.erase(pendingIt);
+            Stats.BlocksInvalidated++;
+            BlockArena.Free(block);
+            continue;
+        }
+
         FastBlockLookupRegions[block->StartAddrLocal >> 27][(block->StartAddrLocal & 0x7FFFFFF) / 2] = (u64)UINT32_MAX << 32;
         if (block->Num == 0)
-            JitBlocks9.erase(block->StartAddr);
+            JitBlocks9.Remove(block);
         else
-            JitBlocks7.erase(block->StartAddr);
+            JitBlocks7.Remove(block);
+        Stats.BlocksInvalidated++;
 
         if (!literalInvalidation)
         {
@@ -1023,7 +1369,7 @@ void ARMJIT::InvalidateByAddr(u32 localAddr) noexcept
         }
         else
         {
-            delete block;
+            BlockArena.Free(block);
         }
     }
 }
@@ -1066,7 +1412,10 @@ JitBlockEntry ARMJIT::LookUpBlock(u32 num, u64* entries, u32 offset, u32 addr) n
 {
     u64* entry = &entries[offset / 2];
     if (*entry >> 32 == (addr | num))
+    {
+        JITCompiler.CountZoneHit((u32)*entry);
         return JITCompiler.AddEntryOffset((u32)*entry);
+    }
     return NULL;
 }
 
@@ -1113,47 +1462,222 @@ void ARMJIT::ResetBlockCache() noexcept
 {
     Log(LogLevel::Debug, "Resetting JIT block cache...\n");
 
+    // queued blocks are only known to the code index
+    WaitForCompileThread();
+    for (auto& job : CompileJobs)
+    {
+        if (job->Block)
+            UnlinkJitBlock(job->Block);
+    }
+    CompileJobs.clear();
+    CompileJobsDone = 0;
+    PendingBlocks.clear();
+
     // could be replace through a function which only resets
     // the permissions but we're too lazy
     Memory.Reset();
 
     InvalidLiterals.Clear();
+    DeferredBlocks.clear();
     for (int i = 0; i < ARMJIT_Memory::memregions_Count; i++)
     {
         if (FastBlockLookupRegions[i])
             memset(FastBlockLookupRegions[i], 0xFF, CodeRegionSizes[i] * sizeof(u64) / 2);
     }
-    for (auto it = RestoreCandidates.begin(); it != RestoreCandidates.end(); it++)
-        delete it->second;
     RestoreCandidates.clear();
-    for (auto it : JitBlocks9)
+    for (JitBlockDirectory* blocks : {&JitBlocks9, &JitBlocks7})
     {
-        JitBlock* block = it.second;
-        for (int j = 0; j < block->NumAddresses; j++)
+        for (JitBlock* block = blocks->First(); block; block = JitBlockDirectory::Next(block))
         {
-            u32 addr = block->AddressRanges()[j];
-            AddressRange* range = &CodeMemRegions[addr >> 27][(addr & 0x7FFFFFF) / 512];
-            range->Blocks.Clear();
-            range->Code = 0;
+            for (int j = 0; j < block->NumAddresses; j++)
+            {
+                u32 addr = block->AddressRanges()[j];
+                AddressRange* range = &CodeMemRegions[addr >> 27][(addr & 0x7FFFFFF) / 512];
+                range->Blocks.Clear();
+                range->Code = 0;
+            }
         }
-        delete block;
+        blocks->Clear();
     }
-    for (auto it : JitBlocks7)
+    BlockArena.Reset();
+
+    JITCompiler.Reset();
+}
+
+void ARMJIT::UnlinkJitBlock(JitBlock* block) noexcept
+{
+    for (int i = 0; i < block->NumAddresses; i++)
     {
-        JitBlock* block = it.second;
-        for (int j = 0; j < block->NumAddresses; j++)
+        u32 addr = block->AddressRanges()[i];
+        AddressRange* region = CodeMemRegions[addr >> 27];
+        AddressRange* range = &region[(addr & 0x7FFFFFF) / 512];
+
+        if (!range->Blocks.RemoveByValue(block))
+            continue;
+
+        // the remaining blocks might still cover parts of the range
+        range->Code = 0;
+        for (int j = 0; j < range->Blocks.Length; j++)
         {
-            u32 addr = block->AddressRanges()[j];
-            AddressRange* range = &CodeMemRegions[addr >> 27][(addr & 0x7FFFFFF) / 512];
-            range->Blocks.Clear();
-            range->Code = 0;
+            JitBlock* other = range->Blocks[j];
+            for (int k = 0; k < other->NumAddresses; k++)
+            {
+                if (other->AddressRanges()[k] == addr)
+                    range->Code |= other->AddressMasks()[k];
+            }
+        }
+
+        if (range->Blocks.Length == 0
+            && !PageContainsCode(&region[(addr & 0x7FFF000 & ~(Memory.PageSize - 1)) / 512], Memory.PageSize))
+        {
+            Memory.SetCodeProtection(addr >> 27, addr & 0x7FFFFFF, false);
         }
-        delete block;
     }
-    JitBlocks9.clear();
-    JitBlocks7.clear();
 
-    JITCompiler.Reset();
+    // the fast map entry might already belong to a block at another mirror
+    u64* entry = &FastBlockLookupRegions[block->StartAddrLocal >> 27][(block->StartAddrLocal & 0x7FFFFFF) / 2];
+    if ((*entry >> 32) == (block->StartAddr | block->Num)
+        && JITCompiler.AddEntryOffset((u32)*entry) == block->EntryPoint)
+    {
+        *entry = (u64)UINT32_MAX << 32;
+    }
+}
+
+void ARMJIT::RecycleCodeZone() noexcept
+{
+    if (JITCompiler.NumCodeZones < 2)
+    {
+        ResetBlockCache();
+        return;
+    }
+
+    // the zone whose blocks were entered the least recently is reused.
+    // Hit counts are halved on every recycle so they decay over time
+    int cur = JITCompiler.CurCodeZone;
+    int victim = -1;
+    for (int i = 1; i < JITCompiler.NumCodeZones; i++)
+    {
+        int zone = (cur + i) % JITCompiler.NumCodeZones;
+        if (victim == -1 || JITCompiler.CodeZoneHits[zone] < JITCompiler.CodeZoneHits[victim])
+            victim = zone;
+    }
+
+    int evicted = 0;
+    for (JitBlockDirectory* blocks : {&JitBlocks9, &JitBlocks7})
+    {
+        for (JitBlock* block = blocks->First(); block;)
+        {
+            JitBlock* next = JitBlockDirectory::Next(block);
+            if (JITCompiler.CodeZoneOf(block->EntryPoint) == victim)
+            {
+                UnlinkJitBlock(block);
+                blocks->Remove(block);
+                BlockArena.Free(block);
+                evicted++;
+            }
+            block = next;
+        }
+    }
+    // retired blocks aren't linked anywhere anymore
+    for (auto it = RestoreCandidates.begin(); it != RestoreCandidates.end();)
+    {
+        if (JITCompiler.CodeZoneOf(it->second->EntryPoint) == victim)
+        {
+            BlockArena.Free(it->second);
+            it = RestoreCandidates.erase(it);
+            evicted++;
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    Stats.BlocksEvicted += evicted;
+    Log(LogLevel::Debug, "JIT code zone %d full, recycling zone %d (%u hits, %d blocks)\n",
+        cur, victim, JITCompiler.CodeZoneHits[victim], evicted);
+
+    JITCompiler.ResetCodeZone(victim);
+
+    for (int i = 0; i < JITCompiler.NumCodeZones; i++)
+        JITCompiler.CodeZoneHits[i] >>= 1;
+}
+
+// a list of entries, each being the cpu, start address and instruction hash
+// of a block followed by the amount and addresses of its volatile literals
+static constexpr char PersistentCacheMagic[8] = {'M', 'E', 'L', 'O', 'N', 'J', 'I', 'T'};
+static constexpr u32 PersistentCacheVersion = 1;
+
+bool ARMJIT::LoadPersistentCache(const std::string& path) noexcept
+{
+    PersistentBlocks.clear();
+    PersistentBlocksDirty = false;
+
+    Platform::FileHandle* file = Platform::OpenFile(path, Platform::FileMode::Read);
+    if (!file)
+        return false;
+
+    char magic[8];
+    u32 version, numEntries;
+    if (Platform::FileRead(magic, sizeof(magic), 1, file) != 1
+        || memcmp(magic, PersistentCacheMagic, sizeof(magic)) != 0
+        || Platform::FileRead(&version, sizeof(u32), 1, file) != 1
+        || version != PersistentCacheVersion
+        || Platform::FileRead(&numEntries, sizeof(u32), 1, file) != 1)
+    {
+        Log(LogLevel::Warn, "JIT: ignoring invalid block cache %s\n", path.c_str());
+        Platform::CloseFile(file);
+        return false;
+    }
+
+    for (u32 i = 0; i < numEntries; i++)
+    {
+        u32 entry[4];
+        if (Platform::FileRead(entry, sizeof(u32), 4, file) != 4 || entry[0] > 1 || entry[3] > 32)
+            break;
+
+        PersistentBlockInfo info;
+        info.InstrHash = entry[2];
+        info.VolatileLiterals.resize(entry[3]);
+        if (Platform::FileRead(info.VolatileLiterals.data(), sizeof(u32), entry[3], file) != entry[3])
+            break;
+
+        PersistentBlocks[BlockKey(entry[0], entry[1])] = std::move(info);
+    }
+
+    Platform::CloseFile(file);
+
+    Log(LogLevel::Info, "JIT: loaded %zu cached blocks from %s\n", PersistentBlocks.size(), path.c_str());
+    return true;
+}
+
+bool ARMJIT::SavePersistentCache(const std::string& path) noexcept
+{
+    if (!PersistentBlocksDirty)
+        return true;
+
+    Platform::FileHandle* file = Platform::OpenFile(path, Platform::FileMode::Write);
+    if (!file)
+    {
+        Log(LogLevel::Warn, "JIT: couldn't write block cache %s\n", path.c_str());
+        return false;
+    }
+
+    u32 numEntries = PersistentBlocks.size();
+    Platform::FileWrite(PersistentCacheMagic, sizeof(PersistentCacheMagic), 1, file);
+    Platform::FileWrite(&PersistentCacheVersion, sizeof(u32), 1, file);
+    Platform::FileWrite(&numEntries, sizeof(u32), 1, file);
+    for (auto& it : PersistentBlocks)
+    {
+        u32 entry[4] = {(u32)(it.first >> 32), (u32)it.first, it.second.InstrHash, (u32)it.second.VolatileLiterals.size()};
+        Platform::FileWrite(entry, sizeof(u32), 4, file);
+        Platform::FileWrite(it.second.VolatileLiterals.data(), sizeof(u32), entry[3], file);
+    }
+
+    Platform::CloseFile(file);
+
+    PersistentBlocksDirty = false;
+    return true;
 }
 
 void ARMJIT::JitEnableWrite() noexcept
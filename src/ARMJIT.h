@@ -20,9 +20,13 @@
 #define ARMJIT_H
 
 #include <algorithm>
+#include <atomic>
 #include <optional>
 #include <memory>
+#include <string>
+#include <vector>
 #include "types.h"
+#include "Platform.h"
 #include "MemConstants.h"
 #include "Args.h"
 #include "ARMJIT_Memory.h"
@@ -54,6 +58,15 @@ public:
     void JitEnableExecute() noexcept;
     void CompileBlock(ARM* cpu) noexcept;
     void ResetBlockCache() noexcept;
+    void RecycleCodeZone() noexcept;
+    void BeginFrame() noexcept;
+    // the compiler reads some of the emulated state (memory timings, ITCM size, ...),
+    // this has to be called before any of it changes
+    void WaitForCompileThread() noexcept;
+
+    // what was learned about the blocks of a game can be kept across sessions
+    bool LoadPersistentCache(const std::string& path) noexcept;
+    bool SavePersistentCache(const std::string& path) noexcept;
 
     template <u32 num, int region>
     void CheckAndInvalidate(u32 addr) noexcept
@@ -72,6 +85,48 @@ private:
     bool LiteralOptimizations = false;
     bool BranchOptimizations = false;
     bool FastMemory = false;
+    unsigned CompileThreshold = 1;
+    unsigned CompileBudget = 0;
+    bool BackgroundCompile = false;
+
+    unsigned CompiledThisFrame = 0;
+    // how often blocks which weren't compiled yet have been interpreted
+    std::unordered_map<u64, u32> DeferredBlocks {};
+    static constexpr size_t MaxDeferredBlocks = 0x4000;
+
+    bool DeferCompilation(u32 num, u32 blockAddr) noexcept;
+    void SnapshotLiteral(ARM* cpu, bool thumb, FetchedInstr& instr) noexcept;
+
+    // A block handed to the compile thread is already entered into the code index,
+    // so writes to it are noticed, but only gets into the block directory and the
+    // fast map once it's installed at the start of the next frame.
+    // The compile thread only ever looks at the copy of the instructions
+    struct CompileJob
+    {
+        JitBlock* Block; // NULL if it was invalidated in the meantime
+        ARM* CPU;
+        bool Thumb;
+        bool HasMemoryInstr;
+        int InstrsCount;
+        FetchedInstr Instrs[32];
+        JitBlockEntry EntryPoint; // NULL if the code zone was full
+    };
+    std::vector<std::unique_ptr<CompileJob>> CompileJobs {};
+    // keyed by cpu and local start address
+    std::unordered_map<u64, CompileJob*> PendingBlocks {};
+    u32 CompileJobsDone = 0;
+    Platform::Mutex* CompileJobsLock = nullptr;
+
+    Platform::Thread* CompileThread = nullptr;
+    std::atomic_bool CompileThreadRunning = false;
+    Platform::Semaphore* Sema_CompileStart = nullptr;
+    Platform::Semaphore* Sema_CompileDone = nullptr;
+
+    void StartCompileThread() noexcept;
+    void StopCompileThread() noexcept;
+    void CompileThreadFunc() noexcept;
+    void QueueCompileJob(ARM* cpu, bool thumb, FetchedInstr instrs[], int instrsCount, bool hasMemoryInstr, JitBlock* block) noexcept;
+    void InstallCompiledBlocks() noexcept;
 
 public:
     melonDS::NDS& NDS;
@@ -79,11 +134,13 @@ public:
     friend class ARMJIT_Memory;
     void blockSanityCheck(u32 num, u32 blockAddr, JitBlockEntry entry) noexcept;
     void RetireJitBlock(JitBlock* block) noexcept;
+    void UnlinkJitBlock(JitBlock* block) noexcept;
 
     int GetMaxBlockSize() const noexcept { return MaxBlockSize; }
     bool LiteralOptimizationsEnabled() const noexcept { return LiteralOptimizations; }
     bool BranchOptimizationsEnabled() const noexcept { return BranchOptimizations; }
     bool FastMemoryEnabled() const noexcept { return FastMemory; }
+    bool BackgroundCompileEnabled() const noexcept { return BackgroundCompile; }
 
     void SetJITArgs(JITArgs args) noexcept;
     void SetMaxBlockSize(int size) noexcept;
@@ -92,11 +149,35 @@ public:
     void SetFastMemory(bool enabled) noexcept;
 
     Compiler JITCompiler;
-    std::unordered_map<u32, JitBlock*> JitBlocks9 {};
-    std::unordered_map<u32, JitBlock*> JitBlocks7 {};
+    // held while compiling and while the fault handler patches compiled code
+    Platform::Mutex* CompilerLock = nullptr;
+    // running totals, for profiling
+    struct Statistics
+    {
+        u64 BlocksCompiled;
+        u64 BlocksRestored;
+        u64 BlocksInvalidated;
+        u64 BlocksEvicted;
+    } Stats {};
+
+    JitBlockArena BlockArena {};
+    JitBlockDirectory JitBlocks9 {};
+    JitBlockDirectory JitBlocks7 {};
 
     std::unordered_map<u32, JitBlock*> RestoreCandidates {};
 
+    // blocks whose literal loads were overwritten at runtime, keyed by cpu and start address.
+    // Unlike everything else here it survives resets and is only
+    // cleared by loading another cache
+    struct PersistentBlockInfo
+    {
+        u32 InstrHash;
+        std::vector<u32> VolatileLiterals;
+    };
+    std::unordered_map<u64, PersistentBlockInfo> PersistentBlocks {};
+    bool PersistentBlocksDirty = false;
+
+    static u64 BlockKey(u32 num, u32 blockAddr) noexcept { return ((u64)num << 32) | blockAddr; }
 
     AddressRange CodeIndexITCM[ITCMPhysicalSize / 512] {};
     AddressRange CodeIndexMainRAM[MainRAMMaxSize / 512] {};
@@ -194,6 +275,10 @@ public:
     void JitEnableExecute() noexcept {}
     void CompileBlock(ARM*) noexcept {}
     void ResetBlockCache() noexcept {}
+    void BeginFrame() noexcept {}
+    void WaitForCompileThread() noexcept {}
+    bool LoadPersistentCache(const std::string&) noexcept { return false; }
+    bool SavePersistentCache(const std::string&) noexcept { return false; }
     template <u32, int>
     void CheckAndInvalidate(u32 addr) noexcept {}
 
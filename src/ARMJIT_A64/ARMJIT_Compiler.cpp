@@ -24,6 +24,7 @@
 #include "../NDS.h"
 #include "../ARMJIT_Global.h"
 
+#include <algorithm>
 #include <stdlib.h>
 
 using namespace Arm64Gen;
@@ -448,6 +449,10 @@ Compiler::Compiler(melonDS::NDS& nds) : Arm64Gen::ARM64XEmitter(), NDS(nds)
     JitMemMainSize -= JitMemSecondarySize;
 
     SetCodeBase((u8*)GetRWPtr(), (u8*)GetRXPtr());
+
+    // whatever is left at the end of the main region after the last whole zone stays unused
+    NumCodeZones = std::clamp<int>(JitMemMainSize >> CodeZoneShift, 1, MaxCodeZones);
+    SecondaryZoneSize = (JitMemSecondarySize / NumCodeZones) & ~3;
 }
 
 Compiler::~Compiler()
@@ -675,17 +680,6 @@ void Compiler::Comp_BranchSpecialBehaviour(bool taken)
 
 JitBlockEntry Compiler::CompileBlock(ARM* cpu, bool thumb, FetchedInstr instrs[], int instrsCount, bool hasMemInstr)
 {
-    if (JitMemMainSize - GetCodeOffset() < 1024 * 16)
-    {
-        Log(LogLevel::Debug, "JIT near memory full, resetting...\n");
-        NDS.JIT.ResetBlockCache();
-    }
-    if ((JitMemMainSize +  JitMemSecondarySize) - OtherCodeRegion < 1024 * 8)
-    {
-        Log(LogLevel::Debug, "JIT far memory full, resetting...\n");
-        NDS.JIT.ResetBlockCache();
-    }
-
     JitBlockEntry res = (JitBlockEntry)GetRXPtr();
 
     Thumb = thumb;
@@ -839,6 +833,56 @@ void Compiler::Reset()
 
     for (int i = 0; i < (JitMemMainSize + JitMemSecondarySize) / 4; i++)
         *(((u32*)GetRWPtr()) + i) = brk_0;
+
+    CurCodeZone = 0;
+    memset(CodeZoneHits, 0, sizeof(CodeZoneHits));
+}
+
+bool Compiler::CodeZoneFull()
+{
+    ptrdiff_t mainEnd = NumCodeZones == 1
+        ? JitMemMainSize
+        : (ptrdiff_t)(CurCodeZone + 1) << CodeZoneShift;
+    ptrdiff_t secondaryEnd = NumCodeZones == 1
+        ? JitMemMainSize + JitMemSecondarySize
+        : JitMemMainSize + (CurCodeZone + 1) * SecondaryZoneSize;
+
+    return mainEnd - GetCodeOffset() < 1024 * 16 || secondaryEnd - OtherCodeRegion < 1024 * 8;
+}
+
+void Compiler::ResetCodeZone(int zone)
+{
+    const u32 brk_0 = 0xD4200000;
+
+    ptrdiff_t mainZone = (ptrdiff_t)zone << CodeZoneShift;
+    ptrdiff_t secondaryZone = JitMemMainSize + zone * SecondaryZoneSize;
+
+    for (auto it = LoadStorePatches.begin(); it != LoadStorePatches.end();)
+    {
+        ptrdiff_t offset = it->first;
+        if ((offset >= mainZone && offset < mainZone + (1 << CodeZoneShift))
+            || (offset >= secondaryZone && offset < secondaryZone + SecondaryZoneSize))
+            it = LoadStorePatches.erase(it);
+        else
+            it++;
+    }
+
+    SetCodePtr(secondaryZone);
+    for (u32 i = 0; i < SecondaryZoneSize / 4; i++)
+        *(((u32*)GetRWPtr()) + i) = brk_0;
+    // unlike the main region code written here isn't flushed per block,
+    // so make sure nothing of the old code survives in the icache
+    FlushIcacheSection((u8*)GetRXPtr(), (u8*)GetRXPtr() + SecondaryZoneSize);
+
+    SetCodePtr(mainZone);
+    for (u32 i = 0; i < (1 << CodeZoneShift) / 4; i++)
+        *(((u32*)GetRWPtr()) + i) = brk_0;
+    FlushIcacheSection((u8*)GetRXPtr(), (u8*)GetRXPtr() + (1 << CodeZoneShift));
+
+    OtherCodeRegion = secondaryZone;
+
+    CurCodeZone = zone;
+    CodeZoneHits[zone] = 0;
 }
 
 void Compiler::Comp_AddCycles_C(bool forceNonConstant)
@@ -121,6 +121,29 @@ public:
 
     void Reset();
 
+    // the main and secondary code regions are split into zones which are
+    // recycled one at a time (see ARMJIT::RecycleCodeZone)
+    static constexpr int MaxCodeZones = 16;
+    static constexpr int CodeZoneShift = 21;
+
+    // still reads literals from memory and touches the CPU state in Comp_JumpTo
+    static constexpr bool SupportsBackgroundCompile = false;
+
+    int NumCodeZones = 1;
+    int CurCodeZone = 0;
+    u32 CodeZoneHits[MaxCodeZones] {};
+
+    void CountZoneHit(u32 entryOffset)
+    {
+        CodeZoneHits[entryOffset >> CodeZoneShift]++;
+    }
+    int CodeZoneOf(JitBlockEntry entry)
+    {
+        return SubEntryOffset(entry) >> CodeZoneShift;
+    }
+    bool CodeZoneFull();
+    void ResetCodeZone(int zone);
+
     void Comp_AddCycles_C(bool forceNonConstant = false);
     void Comp_AddCycles_CI(u32 numI);
     void Comp_AddCycles_CI(u32 c, Arm64Gen::ARM64Reg numI, Arm64Gen::ArithOption shift);
@@ -261,6 +284,7 @@ public:
 
     u32 JitMemSecondarySize;
     u32 JitMemMainSize;
+    u32 SecondaryZoneSize;
 
     std::unordered_map<ptrdiff_t, LoadStorePatch> LoadStorePatches; 
 
@@ -70,6 +70,12 @@ struct FetchedInstr
     u16 CodeCycles;
     u32 DataRegion;
 
+    // taken while the block is analysed, as the compiler
+    // might run on another thread than the emulation
+    u8 DataMemRegion;
+    bool LiteralValid;
+    u32 LiteralValue;
+
     ARMInstrInfo::Info Info;
 };
 
@@ -826,7 +826,12 @@ bool ARMJIT_Memory::FaultHandler(FaultDescription& faultDesc, melonDS::NDS& nds)
             rewriteToSlowPath = !nds.JIT.Memory.MapAtAddress(faultDesc.EmulatedFaultAddr);
 
         if (rewriteToSlowPath)
+        {
+            // the compile thread might be emitting code at the same time
+            Platform::Mutex_Lock(nds.JIT.CompilerLock);
             faultDesc.FaultPC = nds.JIT.JITCompiler.RewriteMemAccess(faultDesc.FaultPC);
+            Platform::Mutex_Unlock(nds.JIT.CompilerLock);
+        }
 
         return true;
     }
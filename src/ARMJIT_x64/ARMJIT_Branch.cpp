@@ -57,8 +57,6 @@ void Compiler::Comp_JumpTo(u32 addr, bool forceNonConstantCycles)
         ARMv5* cpu9 = (ARMv5*)CurCPU;
 
         u32 regionCodeCycles = cpu9->MemTimings[addr >> 12][0];
-        u32 compileTimeCodeCycles = cpu9->RegionCodeCycles;
-        cpu9->RegionCodeCycles = regionCodeCycles;
 
         if (Exit)
             MOV(32, MDisp(RCPU, offsetof(ARMv5, RegionCodeCycles)), Imm32(regionCodeCycles));
@@ -72,15 +70,12 @@ void Compiler::Comp_JumpTo(u32 addr, bool forceNonConstantCycles)
             // doesn't matter if we put garbage in the MSbs there
             if (addr & 0x2)
             {
-                cpu9->CodeRead32(addr-2, true);
-                cycles += cpu9->CodeCycles;
-                cpu9->CodeRead32(addr+2, false);
-                cycles += CurCPU->CodeCycles;
+                cycles += cpu9->CodeFetchCycles(addr-2, true, regionCodeCycles);
+                cycles += cpu9->CodeFetchCycles(addr+2, false, regionCodeCycles);
             }
             else
             {
-                cpu9->CodeRead32(addr, true);
-                cycles += cpu9->CodeCycles;
+                cycles += cpu9->CodeFetchCycles(addr, true, regionCodeCycles);
             }
         }
         else
@@ -88,24 +83,15 @@ void Compiler::Comp_JumpTo(u32 addr, bool forceNonConstantCycles)
             addr &= ~0x3;
             newPC = addr+4;
 
-            cpu9->CodeRead32(addr, true);
-            cycles += cpu9->CodeCycles;
-            cpu9->CodeRead32(addr+4, false);
-            cycles += cpu9->CodeCycles;
+            cycles += cpu9->CodeFetchCycles(addr, true, regionCodeCycles);
+            cycles += cpu9->CodeFetchCycles(addr+4, false, regionCodeCycles);
         }
-
-        cpu9->RegionCodeCycles = compileTimeCodeCycles;
     }
     else
     {
-        ARMv4* cpu7 = (ARMv4*)CurCPU;
-
         u32 codeRegion = addr >> 24;
         u32 codeCycles = addr >> 15; // cheato
 
-        cpu7->CodeRegion = codeRegion;
-        cpu7->CodeCycles = codeCycles;
-
         if (Exit)
         {
             MOV(32, MDisp(RCPU, offsetof(ARM, CodeRegion)), Imm32(codeRegion));
@@ -117,29 +103,15 @@ void Compiler::Comp_JumpTo(u32 addr, bool forceNonConstantCycles)
             addr &= ~0x1;
             newPC = addr+2;
 
-            // this is necessary because ARM7 bios protection
-            u32 compileTimePC = CurCPU->R[15];
-            CurCPU->R[15] = newPC;
-
             cycles += NDS.ARM7MemTimings[codeCycles][0] + NDS.ARM7MemTimings[codeCycles][1];
-
-            CurCPU->R[15] = compileTimePC;
         }
         else
         {
             addr &= ~0x3;
             newPC = addr+4;
 
-            u32 compileTimePC = CurCPU->R[15];
-            CurCPU->R[15] = newPC;
-
             cycles += NDS.ARM7MemTimings[codeCycles][2] + NDS.ARM7MemTimings[codeCycles][3];
-
-            CurCPU->R[15] = compileTimePC;
         }
-
-        cpu7->CodeRegion = R15 >> 24;
-        cpu7->CodeCycles = addr >> 15;
     }
 
     if (Exit)
@@ -23,6 +23,7 @@
 #include "../NDS.h"
 #include "../ARMJIT_Global.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <stdarg.h>
 
@@ -442,6 +443,10 @@ Compiler::Compiler(melonDS::NDS& nds) : XEmitter(), NDS(nds)
 
     NearSize = FarStart - ResetStart;
     FarSize = (ResetStart + CodeMemSize) - FarStart;
+
+    // whatever is left at the end of the near area after the last whole zone stays unused
+    NumCodeZones = std::clamp<int>(NearSize >> CodeZoneShift, 1, MaxCodeZones);
+    FarZoneSize = FarSize / NumCodeZones;
 }
 
 Compiler::~Compiler()
@@ -640,9 +645,48 @@ void Compiler::Reset()
     NearCode = NearStart;
     FarCode = FarStart;
 
+    CurCodeZone = 0;
+    memset(CodeZoneHits, 0, sizeof(CodeZoneHits));
+
     LoadStorePatches.clear();
 }
 
+bool Compiler::CodeZoneFull()
+{
+    u8* nearEnd = NumCodeZones == 1
+        ? NearStart + NearSize
+        : NearStart + ((CurCodeZone + 1) << CodeZoneShift);
+    u8* farEnd = FarStart + (CurCodeZone + 1) * FarZoneSize;
+
+    return nearEnd - GetCodePtr() < 1024 * 32 || farEnd - FarCode < 1024 * 32; // guess...
+}
+
+void Compiler::ResetCodeZone(int zone)
+{
+    u8* nearZone = NearStart + (zone << CodeZoneShift);
+    u8* farZone = FarStart + zone * FarZoneSize;
+
+    memset(nearZone, 0xcc, 1 << CodeZoneShift);
+    memset(farZone, 0xcc, FarZoneSize);
+
+    for (auto it = LoadStorePatches.begin(); it != LoadStorePatches.end();)
+    {
+        u8* addr = it->first;
+        if ((addr >= nearZone && addr < nearZone + (1 << CodeZoneShift))
+            || (addr >= farZone && addr < farZone + FarZoneSize))
+            it = LoadStorePatches.erase(it);
+        else
+            it++;
+    }
+
+    SetCodePtr(nearZone);
+    NearCode = nearZone;
+    FarCode = farZone;
+
+    CurCodeZone = zone;
+    CodeZoneHits[zone] = 0;
+}
+
 bool Compiler::IsJITFault(const u8* addr)
 {
     return (u64)addr >= (u64)ResetStart && (u64)addr < (u64)ResetStart + CodeMemSize;
@@ -688,17 +732,6 @@ void Compiler::CreateMethod(const char* namefmt, void* start, ...)
 
 JitBlockEntry Compiler::CompileBlock(ARM* cpu, bool thumb, FetchedInstr instrs[], int instrsCount, bool hasMemoryInstr)
 {
-    if (NearSize - (GetCodePtr() - NearStart) < 1024 * 32) // guess...
-    {
-        Log(LogLevel::Debug, "near reset\n");
-        NDS.JIT.ResetBlockCache();
-    }
-    if (FarSize - (FarCode - FarStart) < 1024 * 32) // guess...
-    {
-        Log(LogLevel::Debug, "far reset\n");
-        NDS.JIT.ResetBlockCache();
-    }
-
     ConstantCycles = 0;
     Thumb = thumb;
     Num = cpu->Num;
@@ -88,6 +88,30 @@ public:
 
     void Reset();
 
+    // the near and far code areas are split into zones which are
+    // recycled one at a time (see ARMJIT::RecycleCodeZone)
+    static constexpr int MaxCodeZones = 16;
+    static constexpr int CodeZoneShift = 21;
+
+    // the code generator only reads the fetched instructions and state
+    // which is left alone while it runs (see ARMJIT::WaitForCompileThread)
+    static constexpr bool SupportsBackgroundCompile = true;
+
+    int NumCodeZones = 1;
+    int CurCodeZone = 0;
+    u32 CodeZoneHits[MaxCodeZones] {};
+
+    void CountZoneHit(u32 entryOffset)
+    {
+        CodeZoneHits[entryOffset >> CodeZoneShift]++;
+    }
+    int CodeZoneOf(JitBlockEntry entry)
+    {
+        return SubEntryOffset(entry) >> CodeZoneShift;
+    }
+    bool CodeZoneFull();
+    void ResetCodeZone(int zone);
+
     JitBlockEntry CompileBlock(ARM* cpu, bool thumb, FetchedInstr instrs[], int instrsCount, bool hasMemoryInstr);
 
     void LoadReg(int reg, Gen::X64Reg nativeReg);
@@ -173,7 +197,7 @@ public:
     };
     void Comp_MemAccess(int rd, int rn, const Op2& op2, int size, int flags);
     s32 Comp_MemAccessBlock(int rn, Common::BitSet16 regs, bool store, bool preinc, bool decrement, bool usermode, bool skipLoadingRn);
-    bool Comp_MemLoadLiteral(int size, bool signExtend, int rd, u32 addr);
+    bool Comp_MemLoadLiteral(int rd);
 
     void Comp_ArithTriOp(void (Compiler::*op)(int, const Gen::OpArg&, const Gen::OpArg&),
         Gen::OpArg rd, Gen::OpArg rn, Gen::OpArg op2, bool carryUsed, int opFlags);
@@ -248,6 +272,7 @@ public:
     u8* NearCode {};
     u32 FarSize {};
     u32 NearSize {};
+    u32 FarZoneSize {};
 
     u8* NearStart {};
     u8* FarStart {};
@@ -67,40 +67,14 @@ u8* Compiler::RewriteMemAccess(u8* pc)
     improvement.
 */
 
-bool Compiler::Comp_MemLoadLiteral(int size, bool signExtend, int rd, u32 addr)
+bool Compiler::Comp_MemLoadLiteral(int rd)
 {
-    u32 localAddr = NDS.JIT.LocaliseCodeAddress(Num, addr);
-
-    int invalidLiteralIdx = NDS.JIT.InvalidLiterals.Find(localAddr);
-    if (invalidLiteralIdx != -1)
-    {
+    if (!CurInstr.LiteralValid)
         return false;
-    }
 
     Comp_AddCycles_CDI();
 
-    u32 val;
-    // make sure arm7 bios is accessible
-    u32 tmpR15 = CurCPU->R[15];
-    CurCPU->R[15] = R15;
-    if (size == 32)
-    {
-        CurCPU->DataRead32(addr & ~0x3, &val);
-        val = melonDS::ROR(val, (addr & 0x3) << 3);
-    }
-    else if (size == 16)
-    {
-        CurCPU->DataRead16(addr & ~0x1, &val);
-        if (signExtend)
-            val = ((s32)val << 16) >> 16;
-    }
-    else
-    {
-        CurCPU->DataRead8(addr, &val);
-        if (signExtend)
-            val = ((s32)val << 24) >> 24;
-    }
-    CurCPU->R[15] = tmpR15;
+    u32 val = CurInstr.LiteralValue;
 
     MOV(32, MapReg(rd), Imm32(val));
 
@@ -121,9 +95,7 @@ void Compiler::Comp_MemAccess(int rd, int rn, const Op2& op2, int size, int flag
 
     if (NDS.JIT.LiteralOptimizationsEnabled() && rn == 15 && rd != 15 && op2.IsImm && !(flags & (memop_Post|memop_Store|memop_Writeback)))
     {
-        u32 addr = R15 + op2.Imm * ((flags & memop_SubtractOffset) ? -1 : 1);
-
-        if (Comp_MemLoadLiteral(size, flags & memop_SignExtend, rd, addr))
+        if (Comp_MemLoadLiteral(rd))
             return;
     }
 
@@ -196,9 +168,7 @@ void Compiler::Comp_MemAccess(int rd, int rn, const Op2& op2, int size, int flag
     if ((flags & memop_Writeback) && !(flags & memop_Post))
         MOV(32, rnMapped, R(finalAddr));
 
-    u32 expectedTarget = Num == 0
-        ? NDS.JIT.Memory.ClassifyAddress9(CurInstr.DataRegion)
-        : NDS.JIT.Memory.ClassifyAddress7(CurInstr.DataRegion);
+    u32 expectedTarget = CurInstr.DataMemRegion;
 
     if (NDS.JIT.FastMemoryEnabled() && ((!Thumb && CurInstr.Cond() != 0xE) || NDS.JIT.Memory.IsFastmemCompatible(expectedTarget)))
     {
@@ -422,9 +392,7 @@ s32 Compiler::Comp_MemAccessBlock(int rn, BitSet16 regs, bool store, bool preinc
 
     s32 offset = (regsCount * 4) * (decrement ? -1 : 1);
 
-    int expectedTarget = Num == 0
-        ? NDS.JIT.Memory.ClassifyAddress9(CurInstr.DataRegion)
-        : NDS.JIT.Memory.ClassifyAddress7(CurInstr.DataRegion);
+    int expectedTarget = CurInstr.DataMemRegion;
 
     if (!store)
         Comp_AddCycles_CDI();
@@ -808,8 +776,7 @@ void Compiler::T_Comp_MemImmHalf()
 void Compiler::T_Comp_LoadPCRel()
 {
     u32 offset = (CurInstr.Instr & 0xFF) << 2;
-    u32 addr = (R15 & ~0x2) + offset;
-    if (!NDS.JIT.LiteralOptimizationsEnabled() || !Comp_MemLoadLiteral(32, false, CurInstr.T_Reg(8), addr))
+    if (!NDS.JIT.LiteralOptimizationsEnabled() || !Comp_MemLoadLiteral(CurInstr.T_Reg(8)))
         Comp_MemAccess(CurInstr.T_Reg(8), 15, Op2(offset), 32, 0);
 }
 
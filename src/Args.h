@@ -67,6 +67,21 @@ struct JITArgs
     /// Enabled by default, but frontends should disable this when debugging
     /// so the constants segfaults don't hinder debugging.
     bool FastMemory = true;
+
+    /// How many times a block is run through the interpreter before it gets compiled.
+    /// 1 compiles every block the first time it's reached.
+    unsigned CompileThreshold = 1;
+
+    /// How many blocks may be compiled per frame, 0 meaning no limit.
+    /// Blocks over the budget are interpreted until a later frame.
+    /// Since it's a block count and not a time limit emulation stays deterministic.
+    unsigned CompileBudget = 0;
+
+    /// Compile blocks on a separate thread, they are interpreted until they're ready.
+    /// Finished blocks are only put into use at the start of the next frame,
+    /// so emulation stays deterministic regardless of how fast the thread is.
+    /// Only supported by the x86-64 JIT, ignored elsewhere.
+    bool BackgroundCompile = false;
 };
 
 using ARM9BIOSImage = std::array<u8, ARM9BIOSSize>;
@@ -133,6 +133,9 @@ void ARMv5::UpdateDTCMSetting()
 
 void ARMv5::UpdateITCMSetting()
 {
+#ifdef JIT_ENABLED
+    NDS.JIT.WaitForCompileThread();
+#endif
     if (CP15Control & (1<<18))
     {
         ITCMSize = 0x200 << ((ITCMSetting >> 1) & 0x1F);
@@ -297,6 +300,10 @@ void ARMv5::UpdatePURegions(bool update_all)
 
 void ARMv5::UpdateRegionTimings(u32 addrstart, u32 addrend)
 {
+#ifdef JIT_ENABLED
+    // compiled code has the timings baked in
+    NDS.JIT.WaitForCompileThread();
+#endif
     for (u32 i = addrstart; i < addrend; i++)
     {
         u8 pu = PU_Map[i];
@@ -814,6 +821,17 @@ u32 ARMv5::CodeRead32(u32 addr, bool branch)
     return BusRead32(addr);
 }
 
+u32 ARMv5::CodeFetchCycles(u32 addr, bool branch, u32 regionCodeCycles) const
+{
+    if (addr < ITCMSize)
+        return 1;
+
+    if (regionCodeCycles == 0xFF) // cached memory
+        return (branch || !(addr & 0x1F)) ? kCodeCacheTiming : 1;
+
+    return regionCodeCycles;
+}
+
 
 void ARMv5::DataRead8(u32 addr, u32* val)
 {
@@ -0,0 +1,122 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FrameProfiler.h"
+#include "NDS.h"
+
+namespace melonDS
+{
+
+static_assert(Event_MAX <= ProfMaxEvents, "FrameProfile can't hold all scheduler events");
+
+static const char* const SectionNames[ProfSection_MAX] =
+{
+    "ARM9",
+    "ARM7",
+    "DMA9",
+    "DMA7",
+    "timers",
+    "GPU3D (GX)",
+    "GX FIFO stall",
+    "scheduler",
+};
+
+static const char* const EventNames[Event_MAX] =
+{
+    "LCD (incl. 2D)",
+    "SPU",
+    "Wifi",
+    "RTC",
+    "DisplayFIFO",
+    "ROMTransfer",
+    "ROMSPITransfer",
+    "SPITransfer",
+    "Div",
+    "Sqrt",
+    "DSi SDMMC",
+    "DSi SDIO",
+    "DSi NWifi",
+    "DSi CamIRQ",
+    "DSi CamTransfer",
+    "DSi DSP",
+};
+
+void FrameProfiler::Reset()
+{
+    Profile = {};
+    ResetTicks = Ticks();
+    ResetTime = std::chrono::steady_clock::now();
+}
+
+double FrameProfiler::TicksPerUS() const
+{
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - ResetTime).count();
+    if (us <= 0.0) return 1.0;
+    return (double)(Ticks() - ResetTicks) / us;
+}
+
+std::string FrameProfiler::Report() const
+{
+    std::string ret;
+    char line[128];
+
+    if (!Profile.Frames || !Profile.FrameTicks)
+        return "frame profile: no frames recorded\n";
+
+    double frames = (double)Profile.Frames;
+    double total = (double)Profile.FrameTicks;
+    double tpus = TicksPerUS();
+
+    auto addLine = [&](const char* indent, const char* name, u64 ticks)
+    {
+        snprintf(line, sizeof(line), "%s%-*s %9.1f us/frame  %5.1f%%\n",
+                 indent, 24 - (int)strlen(indent), name,
+                 ticks / frames / tpus, ticks * 100.0 / total);
+        ret += line;
+    };
+
+    snprintf(line, sizeof(line), "frame profile over %llu frames (%.0f us/frame in RunFrame):\n",
+             (unsigned long long)Profile.Frames, total / frames / tpus);
+    ret += line;
+
+    u64 accounted = 0;
+    for (int i = 0; i < ProfSection_MAX; i++)
+    {
+        addLine("  ", SectionNames[i], Profile.SectionTicks[i]);
+        accounted += Profile.SectionTicks[i];
+
+        if (i != ProfSection_Scheduler)
+            continue;
+
+        for (int e = 0; e < Event_MAX; e++)
+        {
+            if (!Profile.EventCalls[e]) continue;
+            addLine("    ", EventNames[e], Profile.EventTicks[e]);
+            snprintf(line, sizeof(line), "      (%.1f calls/frame)\n", Profile.EventCalls[e] / frames);
+            ret += line;
+        }
+    }
+
+    addLine("  ", "other", Profile.FrameTicks > accounted ? Profile.FrameTicks - accounted : 0);
+    return ret;
+}
+
+}
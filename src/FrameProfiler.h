@@ -0,0 +1,136 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <string>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#include "types.h"
+
+// Host-time breakdown of NDS::RunFrame per subsystem and per scheduler event.
+// Only built with ENABLE_FRAME_PROFILER (FRAME_PROFILER_ENABLED); otherwise
+// the PROFILE_* macros expand to nothing and NDS has no profiler member.
+
+namespace melonDS
+{
+
+enum
+{
+    ProfSection_ARM9 = 0,
+    ProfSection_ARM7,
+    ProfSection_DMA9,   // ARM9 DMAs (and DSi NDMAs) while the CPU is stalled on them
+    ProfSection_DMA7,
+    ProfSection_Timers,
+    ProfSection_GPU3D,  // geometry engine (GX FIFO command processing)
+    ProfSection_GXStall,// ARM9 skipped ahead while stalled on a full GX FIFO
+    ProfSection_Scheduler,
+
+    ProfSection_MAX
+};
+
+// SchedListMask is 32 bits wide, so there are never more events than this
+static constexpr int ProfMaxEvents = 32;
+
+struct FrameProfile
+{
+    u64 Frames = 0;
+    u64 FrameTicks = 0;                    // total time spent in RunFrame
+    u64 SectionTicks[ProfSection_MAX] {};
+    u64 EventTicks[ProfMaxEvents] {};      // also counted in ProfSection_Scheduler
+    u64 EventCalls[ProfMaxEvents] {};
+};
+
+class FrameProfiler
+{
+public:
+    FrameProfiler() { Reset(); }
+
+    // raw host tick counter: TSC on x86, the virtual counter on ARM64
+    static u64 Ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        return __rdtsc();
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+        u64 val;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(val));
+        return val;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    void Reset();
+
+    const FrameProfile& GetProfile() const { return Profile; }
+
+    // host ticks per microsecond, measured against the wall clock since Reset()
+    double TicksPerUS() const;
+
+    // human-readable table: time per frame and share of RunFrame per section and event
+    std::string Report() const;
+
+    FrameProfile Profile;
+
+private:
+    u64 ResetTicks;
+    std::chrono::steady_clock::time_point ResetTime;
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(u64& ticks) : Accum(ticks), Start(FrameProfiler::Ticks()) {}
+    ~ProfileScope() { Accum += FrameProfiler::Ticks() - Start; }
+
+private:
+    u64& Accum;
+    u64 Start;
+};
+
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef FRAME_PROFILER_ENABLED
+#define PROFILE_FRAME(prof) \
+    (prof).Profile.Frames++; \
+    melonDS::ProfileScope PROFILE_CONCAT(profScope, __LINE__)((prof).Profile.FrameTicks)
+#define PROFILE_SECTION(prof, section) \
+    melonDS::ProfileScope PROFILE_CONCAT(profScope, __LINE__)((prof).Profile.SectionTicks[section])
+#define PROFILE_EVENT(prof, id) \
+    (prof).Profile.EventCalls[id]++; \
+    melonDS::ProfileScope PROFILE_CONCAT(profScope, __LINE__)((prof).Profile.EventTicks[id])
+#else
+#define PROFILE_FRAME(prof)
+#define PROFILE_SECTION(prof, section)
+#define PROFILE_EVENT(prof, id)
+#endif
+
+#endif // FRAMEPROFILER_H
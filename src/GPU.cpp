@@ -119,6 +119,8 @@ void GPU::ResetVRAMCache() noexcept
 
 void GPU::Reset() noexcept
 {
+    SyncRenderer2D();
+
     VCount = 0;
     NextVCount = -1;
     TotalScanlines = 0;
@@ -199,6 +201,8 @@ void GPU::Reset() noexcept
 
 void GPU::Stop() noexcept
 {
+    SyncRenderer2D();
+
     int fbsize;
     if (GPU3D.IsRendererAccelerated())
         fbsize = (256*3 + 1) * 192;
@@ -215,6 +219,8 @@ void GPU::Stop() noexcept
 
 void GPU::DoSavestate(Savestate* file) noexcept
 {
+    SyncRenderer2D();
+
     file->Section("GPUG");
 
     file->Var16(&VCount);
@@ -295,6 +301,8 @@ void GPU::AssignFramebuffers() noexcept
 
 void GPU::SetRenderer3D(std::unique_ptr<Renderer3D>&& renderer) noexcept
 {
+    SyncRenderer2D();
+
     if (renderer == nullptr)
         GPU3D.SetCurrentRenderer(std::make_unique<SoftRenderer>());
     else
@@ -386,6 +394,8 @@ void GPU::MapVRAM_AB(u32 bank, u8 cnt) noexcept
 
     if (oldcnt == cnt) return;
 
+    SyncRenderer2D();
+
     u8 oldofs = (oldcnt >> 3) & 0x3;
     u8 ofs = (cnt >> 3) & 0x3;
     u32 bankmask = 1 << bank;
@@ -448,6 +458,8 @@ void GPU::MapVRAM_CD(u32 bank, u8 cnt) noexcept
 
     if (oldcnt == cnt) return;
 
+    SyncRenderer2D();
+
     u8 oldofs = (oldcnt >> 3) & 0x7;
     u8 ofs = (cnt >> 3) & 0x7;
     u32 bankmask = 1 << bank;
@@ -533,6 +545,8 @@ void GPU::MapVRAM_E(u32 bank, u8 cnt) noexcept
 
     if (oldcnt == cnt) return;
 
+    SyncRenderer2D();
+
     u32 bankmask = 1 << bank;
 
     if (oldcnt & (1<<7))
@@ -597,6 +611,8 @@ void GPU::MapVRAM_FG(u32 bank, u8 cnt) noexcept
 
     if (oldcnt == cnt) return;
 
+    SyncRenderer2D();
+
     u8 oldofs = (oldcnt >> 3) & 0x7;
     u8 ofs = (cnt >> 3) & 0x7;
     u32 bankmask = 1 << bank;
@@ -697,6 +713,8 @@ void GPU::MapVRAM_H(u32 bank, u8 cnt) noexcept
 
     if (oldcnt == cnt) return;
 
+    SyncRenderer2D();
+
     u32 bankmask = 1 << bank;
 
     if (oldcnt & (1<<7))
@@ -759,6 +777,8 @@ void GPU::MapVRAM_I(u32 bank, u8 cnt) noexcept
 
     if (oldcnt == cnt) return;
 
+    SyncRenderer2D();
+
     u32 bankmask = 1 << bank;
 
     if (oldcnt & (1<<7))
@@ -934,6 +954,8 @@ void GPU::FinishFrame(u32 lines) noexcept
 
 void GPU::BlankFrame() noexcept
 {
+    SyncRenderer2D();
+
     int backbuf = FrontBuffer ? 0 : 1;
     int fbsize;
     if (GPU3D.IsRendererAccelerated())
@@ -1003,6 +1025,13 @@ void GPU::StartScanline(u32 line) noexcept
             NDS.ScheduleEvent(Event_DisplayFIFO, false, 32, 0, 0);
     }
 
+    if (line == 192)
+    {
+        // the 2D renderer may still be working on the last visible scanlines
+        // the frame needs to be complete by VBlank
+        SyncRenderer2D();
+    }
+
     if (VCount == 262)
     {
         // frame end
@@ -76,6 +76,15 @@ public:
     [[nodiscard]] const GPU2D::Renderer2D& GetRenderer2D() const noexcept { return *GPU2D_Renderer; }
     [[nodiscard]] GPU2D::Renderer2D& GetRenderer2D() noexcept { return *GPU2D_Renderer; }
 
+    /// Waits for the 2D renderer to draw the scanlines it queued, if any.
+    /// Needs to happen before anything the 2D renderer draws from is modified
+    /// (VRAM, palette, OAM, VRAM mappings), registers aside.
+    void SyncRenderer2D() noexcept
+    {
+        if (GPU2D_Renderer->HasQueuedScanlines())
+            GPU2D_Renderer->Sync();
+    }
+
     void MapVRAM_AB(u32 bank, u8 cnt) noexcept;
     void MapVRAM_CD(u32 bank, u8 cnt) noexcept;
     void MapVRAM_E(u32 bank, u8 cnt) noexcept;
@@ -151,6 +160,7 @@ public:
     template<typename T>
     void WriteVRAM_LCDC(u32 addr, T val)
     {
+        SyncRenderer2D();
         int bank;
 
         switch (addr & 0xFF8FC000)
@@ -239,6 +249,7 @@ public:
     template<typename T>
     void WriteVRAM_ABG(u32 addr, T val)
     {
+        SyncRenderer2D();
         u32 mask = VRAMMap_ABG[(addr >> 14) & 0x1F];
 
         if (mask & (1<<0))
@@ -300,6 +311,7 @@ public:
     template<typename T>
     void WriteVRAM_AOBJ(u32 addr, T val)
     {
+        SyncRenderer2D();
         u32 mask = VRAMMap_AOBJ[(addr >> 14) & 0xF];
 
         if (mask & (1<<0))
@@ -349,6 +361,7 @@ public:
     template<typename T>
     void WriteVRAM_BBG(u32 addr, T val)
     {
+        SyncRenderer2D();
         u32 mask = VRAMMap_BBG[(addr >> 14) & 0x7];
 
         if (mask & (1<<2))
@@ -387,6 +400,7 @@ public:
     template<typename T>
     void WriteVRAM_BOBJ(u32 addr, T val)
     {
+        SyncRenderer2D();
         u32 mask = VRAMMap_BOBJ[(addr >> 14) & 0x7];
 
         if (mask & (1<<3))
@@ -478,6 +492,7 @@ public:
     template<typename T>
     void WritePalette(u32 addr, T val)
     {
+        SyncRenderer2D();
         addr &= 0x7FF;
 
         *(T*)&Palette[addr] = val;
@@ -493,6 +508,7 @@ public:
     template<typename T>
     void WriteOAM(u32 addr, T val)
     {
+        SyncRenderer2D();
         addr &= 0x7FF;
 
         *(T*)&OAM[addr] = val;
@@ -141,6 +141,51 @@ void Unit::Reset()
     MasterBrightness = 0;
 }
 
+void Unit::CopyRenderState(const Unit& other)
+{
+    Num = other.Num;
+    Enabled = other.Enabled;
+
+    DispCnt = other.DispCnt;
+    memcpy(BGCnt, other.BGCnt, 4*2);
+    memcpy(BGXPos, other.BGXPos, 4*2);
+    memcpy(BGYPos, other.BGYPos, 4*2);
+    memcpy(BGXRef, other.BGXRef, 2*4);
+    memcpy(BGYRef, other.BGYRef, 2*4);
+    memcpy(BGXRefInternal, other.BGXRefInternal, 2*4);
+    memcpy(BGYRefInternal, other.BGYRefInternal, 2*4);
+    memcpy(BGRotA, other.BGRotA, 2*2);
+    memcpy(BGRotB, other.BGRotB, 2*2);
+    memcpy(BGRotC, other.BGRotC, 2*2);
+    memcpy(BGRotD, other.BGRotD, 2*2);
+
+    memcpy(Win0Coords, other.Win0Coords, 4);
+    memcpy(Win1Coords, other.Win1Coords, 4);
+    memcpy(WinCnt, other.WinCnt, 4);
+
+    Win0Active = other.Win0Active;
+    Win1Active = other.Win1Active;
+
+    memcpy(BGMosaicSize, other.BGMosaicSize, 2);
+    memcpy(OBJMosaicSize, other.OBJMosaicSize, 2);
+    BGMosaicY = other.BGMosaicY;
+    BGMosaicYMax = other.BGMosaicYMax;
+    OBJMosaicYCount = other.OBJMosaicYCount;
+    OBJMosaicY = other.OBJMosaicY;
+    OBJMosaicYMax = other.OBJMosaicYMax;
+
+    BlendCnt = other.BlendCnt;
+    BlendAlpha = other.BlendAlpha;
+    EVA = other.EVA;
+    EVB = other.EVB;
+    EVY = other.EVY;
+
+    CaptureLatch = other.CaptureLatch;
+    CaptureCnt = other.CaptureCnt;
+
+    MasterBrightness = other.MasterBrightness;
+}
+
 void Unit::DoSavestate(Savestate* file)
 {
     file->Section((char*)(Num ? "GP2B" : "GP2A"));
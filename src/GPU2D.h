@@ -75,6 +75,10 @@ public:
     void GetBGVRAM(u8*& data, u32& mask) const;
     void GetOBJVRAM(u8*& data, u32& mask) const;
 
+    // copies the registers and the internal state scanlines are drawn from
+    // (not the display FIFO)
+    void CopyRenderState(const Unit& other);
+
     void UpdateMosaicCounters(u32 line);
     void CalculateWindowMask(u32 line, u8* windowMask, const u8* objWindow);
 
@@ -136,6 +140,11 @@ public:
 
     virtual void VBlankEnd(Unit* unitA, Unit* unitB) = 0;
 
+    // renderers that draw scanlines on another thread flag when they have some
+    // queued up; Sync() waits until all of those are drawn
+    bool HasQueuedScanlines() const { return QueuedScanlines; }
+    virtual void Sync() {}
+
     void SetFramebuffer(u32* unitA, u32* unitB)
     {
         Framebuffer[0] = unitA;
@@ -145,6 +154,8 @@ protected:
     u32* Framebuffer[2];
 
     Unit* CurUnit;
+
+    bool QueuedScanlines = false;
 };
 
 }
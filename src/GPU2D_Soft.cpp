@@ -30,6 +30,205 @@ SoftRenderer::SoftRenderer(melonDS::GPU& gpu)
     // mosaic table is initialized at compile-time
 }
 
+SoftRenderer::~SoftRenderer()
+{
+    StopRenderThread();
+
+    if (Sema_ScanlineQueued) Platform::Semaphore_Free(Sema_ScanlineQueued);
+    if (Sema_ScanlineDone) Platform::Semaphore_Free(Sema_ScanlineDone);
+}
+
+void SoftRenderer::SetThreaded(bool threaded)
+{
+    if (threaded == Threaded) return;
+
+    Threaded = threaded;
+    if (Threaded)
+        StartRenderThread();
+    else
+        StopRenderThread();
+}
+
+void SoftRenderer::StartRenderThread()
+{
+    if (!ScanlineQueue)
+    {
+        ScanlineQueue = std::make_unique<QueuedScanline[]>(ScanlineQueueSize);
+        for (u32 i = 0; i < ScanlineQueueSize; i++)
+            ScanlineQueue[i].State = std::make_unique<Unit>(0, GPU);
+
+        Queued3DLines = std::make_unique<u32[]>(192 * 256);
+
+        Sema_ScanlineQueued = Platform::Semaphore_Create();
+        Sema_ScanlineDone = Platform::Semaphore_Create();
+    }
+
+    Platform::Semaphore_Reset(Sema_ScanlineQueued);
+    Platform::Semaphore_Reset(Sema_ScanlineDone);
+    NumQueued = 0;
+    NumSynced = 0;
+
+    RenderThreadRunning = true;
+    RenderThread = Platform::Thread_Create([this]() {
+        RenderThreadFunc();
+    });
+}
+
+void SoftRenderer::StopRenderThread()
+{
+    if (RenderThreadRunning.load(std::memory_order_relaxed))
+    {
+        // finish the queued scanlines first
+        Sync();
+
+        RenderThreadRunning = false;
+        Platform::Semaphore_Post(Sema_ScanlineQueued);
+
+        Platform::Thread_Wait(RenderThread);
+        Platform::Thread_Free(RenderThread);
+        RenderThread = nullptr;
+    }
+}
+
+void SoftRenderer::RenderThreadFunc()
+{
+    u32 next = 0;
+
+    for (;;)
+    {
+        Platform::Semaphore_Wait(Sema_ScanlineQueued);
+        if (!RenderThreadRunning) return;
+
+        QueuedScanline& entry = ScanlineQueue[next % ScanlineQueueSize];
+        next++;
+
+        if (entry.Sprites)
+        {
+            RenderSprites(entry.Line, entry.State.get());
+        }
+        else
+        {
+            CurUnit = entry.State.get();
+            _3DLine = entry._3DLine;
+            RenderScanline(entry.Line, entry.Dst, entry._3DXPos);
+        }
+
+        Platform::Semaphore_Post(Sema_ScanlineDone);
+    }
+}
+
+void SoftRenderer::Sync()
+{
+    while (NumSynced != NumQueued)
+    {
+        Platform::Semaphore_Wait(Sema_ScanlineDone);
+        NumSynced++;
+    }
+
+    QueuedScanlines = false;
+}
+
+bool SoftRenderer::CanQueueScanline(const Unit* unit) const
+{
+    // display capture writes to VRAM, and the display FIFO is
+    // filled while the scanline is being displayed
+    if (unit->CaptureLatch || (unit->CaptureCnt & (1<<31)))
+        return false;
+    if (unit->UsesFIFO())
+        return false;
+
+    return true;
+}
+
+void SoftRenderer::QueueScanline(bool sprites, u32 line, u32* dst, Unit* unit)
+{
+    if ((NumQueued - NumSynced) == ScanlineQueueSize)
+    {
+        Platform::Semaphore_Wait(Sema_ScanlineDone);
+        NumSynced++;
+    }
+
+    QueuedScanline& entry = ScanlineQueue[NumQueued % ScanlineQueueSize];
+    entry.Sprites = sprites;
+    entry.Dst = dst;
+    entry.State->CopyRenderState(*unit);
+
+    if (sprites)
+    {
+        entry.Line = line;
+    }
+    else
+    {
+        entry.Line = GPU.VCount;
+        entry._3DXPos = GPU.GPU3D.GetRenderXPos();
+        entry._3DLine = nullptr;
+
+        if ((unit->Num == 0) && !GPU.GPU3D.IsRendererAccelerated())
+        {
+            entry._3DLine = &Queued3DLines[line * 256];
+            memcpy(entry._3DLine, GPU.GPU3D.GetLine(line), 256*4);
+        }
+
+        // the unit's own state has to move on as if the scanline was drawn
+        AdvanceScanline(entry.Line, unit);
+    }
+
+    NumQueued++;
+    QueuedScanlines = true;
+    Platform::Semaphore_Post(Sema_ScanlineQueued);
+}
+
+void SoftRenderer::AdvanceScanline(u32 line, Unit* unit)
+{
+    // this needs to do what drawing the scanline does to the unit's state:
+    // affine BGs move their reference point, the windows and the mosaic counters advance
+
+    if ((line > 192) || (unit->Num && !unit->Enabled))
+        return;
+
+    if (!(unit->DispCnt & (1<<7)))
+    {
+        u32 bgmode = unit->DispCnt & 0x7;
+
+        // the horizontal window state carries over to the next scanline:
+        // after a full scanline it ends up set if the window wraps around (x1 > x2)
+        if (unit->DispCnt & (1<<14))
+        {
+            if (unit->Win1Coords[0] > unit->Win1Coords[1]) unit->Win1Active |=  0x2;
+            else                                           unit->Win1Active &= ~0x2;
+        }
+        if (unit->DispCnt & (1<<13))
+        {
+            if (unit->Win0Coords[0] > unit->Win0Coords[1]) unit->Win0Active |=  0x2;
+            else                                           unit->Win0Active &= ~0x2;
+        }
+
+        // BG2: affine in modes 2 and 4, extended in mode 5, large in mode 6
+        if ((unit->DispCnt & 0x0400) && (bgmode == 2 || bgmode == 4 || bgmode == 5 || bgmode == 6))
+        {
+            unit->BGXRefInternal[0] += unit->BGRotB[0];
+            unit->BGYRefInternal[0] += unit->BGRotD[0];
+        }
+
+        // BG3: affine in modes 1 and 2, extended in modes 3 to 5
+        if ((unit->DispCnt & 0x0800) && (bgmode >= 1 && bgmode <= 5))
+        {
+            unit->BGXRefInternal[1] += unit->BGRotB[1];
+            unit->BGYRefInternal[1] += unit->BGRotD[1];
+        }
+
+        if (unit->BGMosaicY >= unit->BGMosaicYMax)
+        {
+            unit->BGMosaicY = 0;
+            unit->BGMosaicYMax = unit->BGMosaicSize[1];
+        }
+        else
+            unit->BGMosaicY++;
+    }
+
+    unit->UpdateMosaicCounters(line);
+}
+
 u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
 {
     u32 coloreffect = 0;
@@ -102,35 +301,122 @@ u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
     return val1;
 }
 
-void SoftRenderer::DrawScanline(u32 line, Unit* unit)
+template<u32 effect, bool blendOBJ, bool blend3D>
+void SoftRenderer::ColorCompositeLine()
 {
-    CurUnit = unit;
-
-    int stride = GPU.GPU3D.IsRendererAccelerated() ? (256*3 + 1) : 256;
-    u32* dst = &Framebuffer[CurUnit->Num][stride * line];
+    // same as calling ColorComposite() on each pixel of BGOBJLine
+    // but without any branches, so the compiler can work on several pixels at once:
+    // the conditions are turned into all-ones masks which select between the results
 
-    int n3dline = line;
-    line = GPU.VCount;
+    u32 blendCnt = CurUnit->BlendCnt;
+    u32 eva = CurUnit->EVA;
+    u32 evb = CurUnit->EVB;
+    u32 evy = CurUnit->EVY;
 
-    if (CurUnit->Num == 0)
+    for (int i = 0; i < 256; i++)
     {
-        auto bgDirty = GPU.VRAMDirty_ABG.DeriveState(GPU.VRAMMap_ABG, GPU);
-        GPU.MakeVRAMFlat_ABGCoherent(bgDirty);
-        auto bgExtPalDirty = GPU.VRAMDirty_ABGExtPal.DeriveState(GPU.VRAMMap_ABGExtPal, GPU);
-        GPU.MakeVRAMFlat_ABGExtPalCoherent(bgExtPalDirty);
-        auto objExtPalDirty = GPU.VRAMDirty_AOBJExtPal.DeriveState(&GPU.VRAMMap_AOBJExtPal, GPU);
-        GPU.MakeVRAMFlat_AOBJExtPalCoherent(objExtPalDirty);
+        u32 val1 = BGOBJLine[i];
+        u32 val2 = BGOBJLine[256+i];
+
+        u32 flag1 = val1 >> 24;
+        u32 flag2 = val2 >> 24;
+
+        u32 target2 = (flag2 & 0x80) ? 0x1000 : ((flag2 & 0x40) ? 0x0100 : (flag2 << 8));
+        u32 target1 = (flag1 & 0x80) ? 0x0010 : ((flag1 & 0x40) ? 0x0001 : flag1);
+
+        u32 blend2 = -(u32)((blendCnt & target2) != 0);
+        u32 blend1 = -(u32)((blendCnt & target1) != 0) & -(u32)((WindowMask[i] & 0x20) != 0);
+
+        // sprite blending, with the sprite's own alpha for bitmap sprites
+        u32 objblend = blendOBJ ? (blend2 & -(u32)(flag1 >> 7)) : 0;
+        u32 objalpha = objblend & -(u32)((flag1 >> 6) & 0x1);
+
+        u32 alpha = flag1 & 0x1F;
+        u32 eva1 = (alpha & objalpha) | (eva & ~objalpha);
+        u32 evb1 = ((16 - alpha) & objalpha) | (evb & ~objalpha);
+
+        u32 res = val1;
+        u32 blend4 = 0;
+
+        if (effect == 1)
+            blend4 = blend1 & blend2;
+        else if (effect == 2)
+            res = (ColorBrightnessUp(val1, evy, 0x8) & blend1) | (res & ~blend1);
+        else if (effect == 3)
+            res = (ColorBrightnessDown(val1, evy, 0x7) & blend1) | (res & ~blend1);
+
+        if (blend3D)
+        {
+            // 3D layer blending takes precedence over the regular effects
+            u32 blend5 = blend2 & -(u32)((flag1 >> 6) == 0x1);
+
+            res = (ColorBlend5(val1, val2) & blend5) | (res & ~blend5);
+            blend4 &= ~blend5;
+        }
+
+        if (effect == 1 || blendOBJ)
+        {
+            blend4 |= objblend;
+            res = (ColorBlend4(val1, val2, eva1, evb1) & blend4) | (res & ~blend4);
+        }
+
+        BGOBJLine[i] = res;
     }
-    else
+}
+
+void SoftRenderer::ColorCompositeLine()
+{
+    u32 effect = (CurUnit->BlendCnt >> 6) & 0x3;
+
+    u32 flags = 0;
+    for (int i = 0; i < 256; i++)
+        flags |= BGOBJLine[i];
+
+    // semi-transparent sprites and 3D pixels are blended regardless of the effect
+    // if there are none, there may be nothing to do at all
+    if ((effect == 0) && !(flags & 0xC0000000))
+        return;
+
+    bool blendOBJ = (flags & 0x80000000) != 0;
+    bool blend3D = (flags & 0x40000000) != 0;
+
+    switch (effect | (blendOBJ << 2) | (blend3D << 3))
+    {
+    case 0x1: ColorCompositeLine<1, false, false>(); break;
+    case 0x2: ColorCompositeLine<2, false, false>(); break;
+    case 0x3: ColorCompositeLine<3, false, false>(); break;
+    case 0x4: ColorCompositeLine<0, true, false>(); break;
+    case 0x5: ColorCompositeLine<1, true, false>(); break;
+    case 0x6: ColorCompositeLine<2, true, false>(); break;
+    case 0x7: ColorCompositeLine<3, true, false>(); break;
+    case 0x8: ColorCompositeLine<0, false, true>(); break;
+    case 0x9: ColorCompositeLine<1, false, true>(); break;
+    case 0xA: ColorCompositeLine<2, false, true>(); break;
+    case 0xB: ColorCompositeLine<3, false, true>(); break;
+    case 0xC: ColorCompositeLine<0, true, true>(); break;
+    case 0xD: ColorCompositeLine<1, true, true>(); break;
+    case 0xE: ColorCompositeLine<2, true, true>(); break;
+    case 0xF: ColorCompositeLine<3, true, true>(); break;
+    }
+}
+
+void SoftRenderer::DrawScanline(u32 line, Unit* unit)
+{
+    int stride = GPU.GPU3D.IsRendererAccelerated() ? (256*3 + 1) : 256;
+    u32* dst = &Framebuffer[unit->Num][stride * line];
+
+    if (RenderThreadRunning.load(std::memory_order_relaxed) && CanQueueScanline(unit))
     {
-        auto bgDirty = GPU.VRAMDirty_BBG.DeriveState(GPU.VRAMMap_BBG, GPU);
-        GPU.MakeVRAMFlat_BBGCoherent(bgDirty);
-        auto bgExtPalDirty = GPU.VRAMDirty_BBGExtPal.DeriveState(GPU.VRAMMap_BBGExtPal, GPU);
-        GPU.MakeVRAMFlat_BBGExtPalCoherent(bgExtPalDirty);
-        auto objExtPalDirty = GPU.VRAMDirty_BOBJExtPal.DeriveState(&GPU.VRAMMap_BOBJExtPal, GPU);
-        GPU.MakeVRAMFlat_BOBJExtPalCoherent(objExtPalDirty);
+        QueueScanline(false, line, dst, unit);
+        return;
     }
 
+    Sync();
+    CurUnit = unit;
+
+    int n3dline = line;
+    line = GPU.VCount;
+
     bool forceblank = false;
 
     // scanlines that end up outside of the GPU drawing range
@@ -155,6 +441,35 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
         }
     }
 
+    RenderScanline(line, dst, GPU.GPU3D.GetRenderXPos());
+}
+
+void SoftRenderer::RenderScanline(u32 line, u32* dst, u16 xpos)
+{
+    int stride = GPU.GPU3D.IsRendererAccelerated() ? (256*3 + 1) : 256;
+
+    if (CurUnit->Num == 0)
+    {
+        auto bgDirty = GPU.VRAMDirty_ABG.DeriveState(GPU.VRAMMap_ABG, GPU);
+        GPU.MakeVRAMFlat_ABGCoherent(bgDirty);
+        auto bgExtPalDirty = GPU.VRAMDirty_ABGExtPal.DeriveState(GPU.VRAMMap_ABGExtPal, GPU);
+        GPU.MakeVRAMFlat_ABGExtPalCoherent(bgExtPalDirty);
+        auto objExtPalDirty = GPU.VRAMDirty_AOBJExtPal.DeriveState(&GPU.VRAMMap_AOBJExtPal, GPU);
+        GPU.MakeVRAMFlat_AOBJExtPalCoherent(objExtPalDirty);
+    }
+    else
+    {
+        auto bgDirty = GPU.VRAMDirty_BBG.DeriveState(GPU.VRAMMap_BBG, GPU);
+        GPU.MakeVRAMFlat_BBGCoherent(bgDirty);
+        auto bgExtPalDirty = GPU.VRAMDirty_BBGExtPal.DeriveState(GPU.VRAMMap_BBGExtPal, GPU);
+        GPU.MakeVRAMFlat_BBGExtPalCoherent(bgExtPalDirty);
+        auto objExtPalDirty = GPU.VRAMDirty_BOBJExtPal.DeriveState(&GPU.VRAMMap_BOBJExtPal, GPU);
+        GPU.MakeVRAMFlat_BOBJExtPalCoherent(objExtPalDirty);
+    }
+
+    // see DrawScanline()
+    bool forceblank = (line > 192) || (CurUnit->Num && !CurUnit->Enabled);
+
     if (forceblank)
     {
         for (int i = 0; i < 256; i++)
@@ -254,8 +569,6 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
 
     if (GPU.GPU3D.IsRendererAccelerated())
     {
-        u32 xpos = GPU.GPU3D.GetRenderXPos();
-
         dst[256*3] = masterBrightness |
                      (CurUnit->DispCnt & 0x30000) |
                      (xpos << 24) | ((xpos & 0x100) << 15);
@@ -737,17 +1050,10 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
     }
 
     // color special effects
-    // can likely be optimized
 
     if (!GPU.GPU3D.IsRendererAccelerated())
     {
-        for (int i = 0; i < 256; i++)
-        {
-            u32 val1 = BGOBJLine[i];
-            u32 val2 = BGOBJLine[256+i];
-
-            BGOBJLine[i] = ColorComposite(i, val1, val2);
-        }
+        ColorCompositeLine();
     }
     else
     {
@@ -829,12 +1135,10 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
         }
         else
         {
+            ColorCompositeLine();
+
             for (int i = 0; i < 256; i++)
             {
-                u32 val1 = BGOBJLine[i];
-                u32 val2 = BGOBJLine[256+i];
-
-                BGOBJLine[i]     = ColorComposite(i, val1, val2);
                 BGOBJLine[256+i] = 0;
                 BGOBJLine[512+i] = 0x07000000;
             }
@@ -975,28 +1279,55 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
     {
         // 256-color
 
-        // preload shit as needed
-        if ((xoff & 0x7) || mosaic)
+        if (!mosaic)
         {
-            curtile = *(u16*)&bgvram[(tilemapaddr + ((xoff & 0xF8) >> 2) + ((xoff & widexmask) << 3)) & bgvrammask];
+            // without mosaic, each tile row is fetched once and its 8 pixels drawn in one go
+            for (int i = 0; i < 256;)
+            {
+                curtile = *(u16*)&bgvram[(tilemapaddr + ((xoff & 0xF8) >> 2) + ((xoff & widexmask) << 3)) & bgvrammask];
+
+                if (extpal) curpal = CurUnit->GetBGExtPal(extpalslot, curtile>>12);
+                else        curpal = pal;
+
+                pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 6)
+                                         + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 3);
+                u64 pixels = *(u64*)&bgvram[pixelsaddr & bgvrammask];
+                u32 xflip = (curtile & 0x0400) ? 7 : 0;
 
-            if (extpal) curpal = CurUnit->GetBGExtPal(extpalslot, curtile>>12);
-            else        curpal = pal;
+                for (u32 x = xoff & 0x7; (x < 8) && (i < 256); x++)
+                {
+                    if (WindowMask[i] & (1<<bgnum))
+                    {
+                        color = pixels >> ((x ^ xflip) << 3);
+
+                        if (color)
+                            drawPixel(&BGOBJLine[i], curpal[color], 0x01000000<<bgnum);
+                    }
 
-            pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 6)
-                                     + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 3);
+                    i++;
+                    xoff++;
+                }
+            }
+
+            return;
         }
 
-        if (mosaic) lastxpos = xoff;
+        // preload shit as needed
+        curtile = *(u16*)&bgvram[(tilemapaddr + ((xoff & 0xF8) >> 2) + ((xoff & widexmask) << 3)) & bgvrammask];
+
+        if (extpal) curpal = CurUnit->GetBGExtPal(extpalslot, curtile>>12);
+        else        curpal = pal;
+
+        pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 6)
+                                 + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 3);
+
+        lastxpos = xoff;
 
         for (int i = 0; i < 256; i++)
         {
-            u32 xpos;
-            if (mosaic) xpos = xoff - CurBGXMosaicTable[i];
-            else        xpos = xoff;
+            u32 xpos = xoff - CurBGXMosaicTable[i];
 
-            if ((!mosaic && (!(xpos & 0x7))) ||
-                (mosaic && ((xpos >> 3) != (lastxpos >> 3))))
+            if ((xpos >> 3) != (lastxpos >> 3))
             {
                 // load a new tile
                 curtile = *(u16*)&bgvram[(tilemapaddr + ((xpos & 0xF8) >> 2) + ((xpos & widexmask) << 3)) & bgvrammask];
@@ -1007,7 +1338,7 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
                 pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 6)
                                          + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 3);
 
-                if (mosaic) lastxpos = xpos;
+                lastxpos = xpos;
             }
 
             // draw pixel
@@ -1027,25 +1358,49 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
     {
         // 16-color
 
-        // preload shit as needed
-        if ((xoff & 0x7) || mosaic)
+        if (!mosaic)
         {
-            curtile = *(u16*)&bgvram[((tilemapaddr + ((xoff & 0xF8) >> 2) + ((xoff & widexmask) << 3))) & bgvrammask];
-            curpal = pal + ((curtile & 0xF000) >> 8);
-            pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 5)
-                                     + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 2);
+            // without mosaic, each tile row is fetched once and its 8 pixels drawn in one go
+            for (int i = 0; i < 256;)
+            {
+                curtile = *(u16*)&bgvram[(tilemapaddr + ((xoff & 0xF8) >> 2) + ((xoff & widexmask) << 3)) & bgvrammask];
+                curpal = pal + ((curtile & 0xF000) >> 8);
+                pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 5)
+                                         + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 2);
+                u32 pixels = *(u32*)&bgvram[pixelsaddr & bgvrammask];
+                u32 xflip = (curtile & 0x0400) ? 7 : 0;
+
+                for (u32 x = xoff & 0x7; (x < 8) && (i < 256); x++)
+                {
+                    if (WindowMask[i] & (1<<bgnum))
+                    {
+                        color = (pixels >> ((x ^ xflip) << 2)) & 0x0F;
+
+                        if (color)
+                            drawPixel(&BGOBJLine[i], curpal[color], 0x01000000<<bgnum);
+                    }
+
+                    i++;
+                    xoff++;
+                }
+            }
+
+            return;
         }
 
-        if (mosaic) lastxpos = xoff;
+        // preload shit as needed
+        curtile = *(u16*)&bgvram[((tilemapaddr + ((xoff & 0xF8) >> 2) + ((xoff & widexmask) << 3))) & bgvrammask];
+        curpal = pal + ((curtile & 0xF000) >> 8);
+        pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 5)
+                                 + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 2);
+
+        lastxpos = xoff;
 
         for (int i = 0; i < 256; i++)
         {
-            u32 xpos;
-            if (mosaic) xpos = xoff - CurBGXMosaicTable[i];
-            else        xpos = xoff;
+            u32 xpos = xoff - CurBGXMosaicTable[i];
 
-            if ((!mosaic && (!(xpos & 0x7))) ||
-                (mosaic && ((xpos >> 3) != (lastxpos >> 3))))
+            if ((xpos >> 3) != (lastxpos >> 3))
             {
                 // load a new tile
                 curtile = *(u16*)&bgvram[(tilemapaddr + ((xpos & 0xF8) >> 2) + ((xpos & widexmask) << 3)) & bgvrammask];
@@ -1053,7 +1408,7 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
                 pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 5)
                                          + (((curtile & 0x0800) ? (7-(yoff&0x7)) : (yoff&0x7)) << 2);
 
-                if (mosaic) lastxpos = xpos;
+                lastxpos = xpos;
             }
 
             // draw pixel
@@ -1586,6 +1941,19 @@ void SoftRenderer::InterleaveSprites(u32 prio)
     }
 
 void SoftRenderer::DrawSprites(u32 line, Unit* unit)
+{
+    // sprites for line 0 reset the OBJ mosaic counters, and are drawn during VBlank anyway
+    if (line != 0 && RenderThreadRunning.load(std::memory_order_relaxed) && CanQueueScanline(unit))
+    {
+        QueueScanline(true, line, nullptr, unit);
+        return;
+    }
+
+    Sync();
+    RenderSprites(line, unit);
+}
+
+void SoftRenderer::RenderSprites(u32 line, Unit* unit)
 {
     CurUnit = unit;
 
@@ -2062,7 +2430,6 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
             // 256-color
             pixelsaddr <<= 5;
             pixelsaddr += ((ypos & 0x7) << 3);
-            s32 pixelstride;
 
             if (!window)
             {
@@ -2072,41 +2439,33 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
                     pixelattr |= ((attrib[2] & 0xF000) >> 4);
             }
 
-            if (attrib[1] & 0x1000) // xflip
-            {
-                pixelsaddr += (((width-1) & wmask) << 3);
-                pixelsaddr += ((width-1) & 0x7);
-                pixelsaddr -= ((xoff & wmask) << 3);
-                pixelsaddr -= (xoff & 0x7);
-                pixelstride = -1;
-            }
-            else
-            {
-                pixelsaddr += ((xoff & wmask) << 3);
-                pixelsaddr += (xoff & 0x7);
-                pixelstride = 1;
-            }
+            u32 xflip = (attrib[1] & 0x1000) ? 7 : 0;
 
             for (; xoff < xend;)
             {
-                color = objvram[pixelsaddr & objvrammask];
+                // fetch the whole tile row at once
+                u32 tilexoff = xflip ? (width-1 - xoff) : xoff;
+                u64 pixels = *(u64*)&objvram[(pixelsaddr + ((tilexoff & wmask) << 3)) & objvrammask];
 
-                pixelsaddr += pixelstride;
-
-                if (color)
-                {
-                    if (window) objWindow[xpos] = 1;
-                    else        objLine[xpos] = color | pixelattr;
-                }
-                else if (!window)
+                do
                 {
-                    if (objLine[xpos] == 0)
-                        objLine[xpos] = pixelattr & 0x180000;
-                }
+                    color = (pixels >> (((xoff & 0x7) ^ xflip) << 3)) & 0xFF;
 
-                xoff++;
-                xpos++;
-                if (!(xoff & 0x7)) pixelsaddr += (56 * pixelstride);
+                    if (color)
+                    {
+                        if (window) objWindow[xpos] = 1;
+                        else        objLine[xpos] = color | pixelattr;
+                    }
+                    else if (!window)
+                    {
+                        if (objLine[xpos] == 0)
+                            objLine[xpos] = pixelattr & 0x180000;
+                    }
+
+                    xoff++;
+                    xpos++;
+                }
+                while ((xoff < xend) && (xoff & 0x7));
             }
         }
         else
@@ -2114,7 +2473,6 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
             // 16-color
             pixelsaddr <<= 5;
             pixelsaddr += ((ypos & 0x7) << 2);
-            s32 pixelstride;
 
             if (!window)
             {
@@ -2122,51 +2480,33 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
                 pixelattr |= ((attrib[2] & 0xF000) >> 8);
             }
 
-            // TODO: optimize VRAM access!!
-            // TODO: do xflip better? the 'two pixels per byte' thing makes it a bit shitty
-
-            if (attrib[1] & 0x1000) // xflip
-            {
-                pixelsaddr += (((width-1) & wmask) << 2);
-                pixelsaddr += (((width-1) & 0x7) >> 1);
-                pixelsaddr -= ((xoff & wmask) << 2);
-                pixelsaddr -= ((xoff & 0x7) >> 1);
-                pixelstride = -1;
-            }
-            else
-            {
-                pixelsaddr += ((xoff & wmask) << 2);
-                pixelsaddr += ((xoff & 0x7) >> 1);
-                pixelstride = 1;
-            }
+            u32 xflip = (attrib[1] & 0x1000) ? 7 : 0;
 
             for (; xoff < xend;)
             {
-                if (attrib[1] & 0x1000)
-                {
-                    if (xoff & 0x1) { color = objvram[pixelsaddr & objvrammask] & 0x0F; pixelsaddr--; }
-                    else              color = objvram[pixelsaddr & objvrammask] >> 4;
-                }
-                else
-                {
-                    if (xoff & 0x1) { color = objvram[pixelsaddr & objvrammask] >> 4; pixelsaddr++; }
-                    else              color = objvram[pixelsaddr & objvrammask] & 0x0F;
-                }
+                // fetch the whole tile row at once
+                u32 tilexoff = xflip ? (width-1 - xoff) : xoff;
+                u32 pixels = *(u32*)&objvram[(pixelsaddr + ((tilexoff & wmask) << 2)) & objvrammask];
 
-                if (color)
-                {
-                    if (window) objWindow[xpos] = 1;
-                    else        objLine[xpos] = color | pixelattr;
-                }
-                else if (!window)
+                do
                 {
-                    if (objLine[xpos] == 0)
-                        objLine[xpos] = pixelattr & 0x180000;
-                }
+                    color = (pixels >> (((xoff & 0x7) ^ xflip) << 2)) & 0x0F;
 
-                xoff++;
-                xpos++;
-                if (!(xoff & 0x7)) pixelsaddr += ((attrib[1] & 0x1000) ? -28 : 28);
+                    if (color)
+                    {
+                        if (window) objWindow[xpos] = 1;
+                        else        objLine[xpos] = color | pixelattr;
+                    }
+                    else if (!window)
+                    {
+                        if (objLine[xpos] == 0)
+                            objLine[xpos] = pixelattr & 0x180000;
+                    }
+
+                    xoff++;
+                    xpos++;
+                }
+                while ((xoff < xend) && (xoff & 0x7));
             }
         }
     }
@@ -19,6 +19,10 @@
 #pragma once
 
 #include "GPU2D.h"
+#include "Platform.h"
+
+#include <atomic>
+#include <memory>
 
 namespace melonDS
 {
@@ -31,13 +35,55 @@ class SoftRenderer : public Renderer2D
 {
 public:
     SoftRenderer(melonDS::GPU& gpu);
-    ~SoftRenderer() override {}
+    ~SoftRenderer() override;
 
     void DrawScanline(u32 line, Unit* unit) override;
     void DrawSprites(u32 line, Unit* unit) override;
     void VBlankEnd(Unit* unitA, Unit* unitB) override;
+
+    // when threaded, scanlines are queued along with a copy of the unit's registers
+    // and drawn on a separate thread, until the VRAM/palette/OAM they're drawn from
+    // is modified (see GPU::SyncRenderer2D) or the frame ends
+    void SetThreaded(bool threaded);
+    [[nodiscard]] bool IsThreaded() const noexcept { return Threaded; }
+    void Sync() override;
 private:
     melonDS::GPU& GPU;
+
+    struct QueuedScanline
+    {
+        bool Sprites; // DrawSprites() rather than DrawScanline()
+        u32 Line;     // VCount for scanlines
+        u32* Dst;
+        u32* _3DLine;
+        u16 _3DXPos;
+        std::unique_ptr<Unit> State;
+    };
+
+    static constexpr u32 ScanlineQueueSize = 1024;
+
+    bool Threaded = false;
+    Platform::Thread* RenderThread = nullptr;
+    std::atomic_bool RenderThreadRunning = false;
+    Platform::Semaphore* Sema_ScanlineQueued = nullptr;
+    Platform::Semaphore* Sema_ScanlineDone = nullptr;
+
+    // written by the emulation thread only
+    std::unique_ptr<QueuedScanline[]> ScanlineQueue;
+    u32 NumQueued = 0;
+    u32 NumSynced = 0;
+    // 3D scanlines are fetched when queueing, as GPU3D::GetLine() has to be called in order
+    std::unique_ptr<u32[]> Queued3DLines;
+
+    void StartRenderThread();
+    void StopRenderThread();
+    void RenderThreadFunc();
+    bool CanQueueScanline(const Unit* unit) const;
+    void QueueScanline(bool sprites, u32 line, u32* dst, Unit* unit);
+    void AdvanceScanline(u32 line, Unit* unit);
+    void RenderScanline(u32 line, u32* dst, u16 xpos);
+    void RenderSprites(u32 line, Unit* unit);
+
     alignas(8) u32 BGOBJLine[256*3];
     u32* _3DLine;
 
@@ -67,15 +113,15 @@ private:
 
     static constexpr u32 ColorBlend4(u32 val1, u32 val2, u32 eva, u32 evb) noexcept
     {
-        u32 r =  (((val1 & 0x00003F) * eva) + ((val2 & 0x00003F) * evb) + 0x000008) >> 4;
-        u32 g = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x000800) >> 4) & 0x007F00;
-        u32 b = ((((val1 & 0x3F0000) * eva) + ((val2 & 0x3F0000) * evb) + 0x080000) >> 4) & 0x7F0000;
+        // red and blue are blended together, eva and evb being at most 16 they can't overflow into eachother
+        u32 rb = ((((val1 & 0x3F003F) * eva) + ((val2 & 0x3F003F) * evb) + 0x080008) >> 4) & 0x7F007F;
+        u32 g  = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x000800) >> 4) & 0x007F00;
 
-        if (r > 0x00003F) r = 0x00003F;
-        if (g > 0x003F00) g = 0x003F00;
-        if (b > 0x3F0000) b = 0x3F0000;
+        // saturate the channels that went over 0x3F
+        rb |= (rb & 0x400040) - ((rb & 0x400040) >> 6);
+        g  |= (g  & 0x004000) - ((g  & 0x004000) >> 6);
 
-        return r | g | b | 0xFF000000;
+        return (rb & 0x3F003F) | (g & 0x003F00) | 0xFF000000;
     }
 
     static constexpr u32 ColorBlend5(u32 val1, u32 val2) noexcept
@@ -85,15 +131,13 @@ private:
 
         if (eva == 32) return val1;
 
-        u32 r =  (((val1 & 0x00003F) * eva) + ((val2 & 0x00003F) * evb) + 0x000010) >> 5;
-        u32 g = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x001000) >> 5) & 0x007F00;
-        u32 b = ((((val1 & 0x3F0000) * eva) + ((val2 & 0x3F0000) * evb) + 0x100000) >> 5) & 0x7F0000;
+        u32 rb = ((((val1 & 0x3F003F) * eva) + ((val2 & 0x3F003F) * evb) + 0x100010) >> 5) & 0x7F007F;
+        u32 g  = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x001000) >> 5) & 0x007F00;
 
-        if (r > 0x00003F) r = 0x00003F;
-        if (g > 0x003F00) g = 0x003F00;
-        if (b > 0x3F0000) b = 0x3F0000;
+        rb |= (rb & 0x400040) - ((rb & 0x400040) >> 6);
+        g  |= (g  & 0x004000) - ((g  & 0x004000) >> 6);
 
-        return r | g | b | 0xFF000000;
+        return (rb & 0x3F003F) | (g & 0x003F00) | 0xFF000000;
     }
 
     static constexpr u32 ColorBrightnessUp(u32 val, u32 factor, u32 bias) noexcept
@@ -118,6 +162,8 @@ private:
         return rb | g | 0xFF000000;
     }
     u32 ColorComposite(int i, u32 val1, u32 val2) const;
+    template<u32 effect, bool blendOBJ, bool blend3D> void ColorCompositeLine();
+    void ColorCompositeLine();
 
     template<u32 bgmode> void DrawScanlineBGMode(u32 line);
     void DrawScanlineBGMode6(u32 line);
@@ -25,18 +25,18 @@
 #include "NDS.h"
 #include "GPU.h"
 #include "GPU3D_OpenGL_shaders.h"
-#include "stb_image_write.h"
 
 namespace melonDS
 {
 
-static std::unordered_map<const melonDS::ReplacementTex*, GLuint> gReplGL;
-
-static GLuint GetOrCreateGLTex(const melonDS::ReplacementTex* R){
-    auto it = gReplGL.find(R);
-    if (it != gReplGL.end()) return it->second;
+GLuint GLRenderer::GetOrCreateGLTex(const ReplacementTex* R) const
+{
+    if (!R) return 0;
+    auto it = ReplGLTextures.find(R);
+    if (it == ReplGLTextures.end()) return 0;
+    if (it->second.Name) return it->second.Name;
 
-    if (!R || R->w <= 0 || R->h <= 0 || R->rgba.empty()) return 0;
+    if (R->w <= 0 || R->h <= 0 || R->rgba.empty()) return 0;
 
     // save active unit
     GLint prevActive; glGetIntegerv(GL_ACTIVE_TEXTURE, &prevActive);
@@ -55,10 +55,31 @@ static GLuint GetOrCreateGLTex(const melonDS::ReplacementTex* R){
     // restore active unit
     glActiveTexture(prevActive);
 
-    gReplGL[R] = tex;
+    it->second.Name = tex;
     return tex;
 }
 
+void GLRenderer::ReleaseEvictedReplGLTextures()
+{
+    for (auto it = ReplGLTextures.begin(); it != ReplGLTextures.end();)
+    {
+        if (!it->second.Tex->evicted.load(std::memory_order_acquire))
+        {
+            it++;
+            continue;
+        }
+
+        if (it->second.Name)
+        {
+            glDeleteTextures(1, &it->second.Name);
+            // the name might be handed out again
+            if (BoundReplTex == it->second.Name)
+                BoundReplTex = 0;
+        }
+        it = ReplGLTextures.erase(it);
+    }
+}
+
 bool GLRenderer::BuildRenderShader(u32 flags, const std::string& vs, const std::string& fs)
 {
     char shadername[32];
@@ -368,6 +389,11 @@ GLRenderer::~GLRenderer()
     glDeleteTextures(1, &TexMemID);
     glDeleteTextures(1, &TexPalMemID);
     glDeleteTextures(1, &ReplFallbackTex);
+    for (auto& [R, repl] : ReplGLTextures)
+    {
+        if (repl.Name) glDeleteTextures(1, &repl.Name);
+    }
+    ReplGLTextures.clear();
 
     glDeleteFramebuffers(1, &MainFramebuffer);
     glDeleteFramebuffers(1, &DownscaleFramebuffer);
@@ -421,6 +447,8 @@ void GLRenderer::Reset(GPU& gpu)
 {
     // This is where the compositor's Reset() method would be called,
     // except there's no such method right now.
+
+    ReplCache.Reset();
 }
 
 void GLRenderer::SetBetterPolygons(bool betterpolygons) noexcept
@@ -526,9 +554,7 @@ void GLRenderer::SetupPolygon(GLRenderer::RendererPolygon* rp, Polygon* polygon)
     if (fmt == 0 || !melonDS::TexReplace_ReplaceEnabled()) {
         rp->ReplTex = nullptr; // у полигона нет текстуры → замены быть не может
     } else {
-        u32 vramaddr = (texparam & 0xFFFF) << 3;
-        auto R = GetBound(vramaddr, texparam, polygon->TexPalette);
-        rp->ReplTex = R ? R.get() : nullptr;
+        rp->ReplTex = ReplBinds.Lookup(texparam, polygon->TexPalette); // снимок кадра, без локов
     }
 }
 
@@ -1521,18 +1547,21 @@ void GLRenderer::RenderFrame(GPU& gpu)
     // как в софте
     auto textureDirty = gpu.VRAMDirty_Texture.DeriveState(gpu.VRAMMap_Texture, gpu);
     auto texPalDirty  = gpu.VRAMDirty_TexPal.DeriveState(gpu.VRAMMap_TexPal, gpu);
-    gpu.MakeVRAMFlat_TextureCoherent(textureDirty);
-    gpu.MakeVRAMFlat_TexPalCoherent(texPalDirty);
+    bool textureChanged = gpu.MakeVRAMFlat_TextureCoherent(textureDirty);
+    bool texPalChanged  = gpu.MakeVRAMFlat_TexPalCoherent(texPalDirty);
 
-    if (melonDS::TexReplace_ReplaceEnabled()) {
-        ClearBindings();
-    }
+    ReplCache.Invalidate(gpu, textureChanged ? textureDirty.Data : nullptr,
+                              texPalChanged ? texPalDirty.Data : nullptr, ReplBinds);
 
-    if (melonDS::TexReplace_DumpEnabled() || melonDS::TexReplace_ReplaceEnabled()) {
-        static thread_local std::unordered_set<uint64_t> seenFrame;
-        seenFrame.clear();
+    ReleaseEvictedReplGLTextures();
 
-        EnsureDump3DDir();
+    const bool replace = melonDS::TexReplace_ReplaceEnabled();
+    const bool wantRGBA = melonDS::TexReplace_DumpEnabled() || melonDS::TexReplace_MigrateEnabled();
+
+    ReplBinds.Begin();
+    if (wantRGBA || replace) {
+        ReplSeen.clear();
+        std::vector<uint8_t> rgba;
 
         for (u32 i = 0; i < gpu.GPU3D.RenderNumPolygons; i++) {
             auto* p = gpu.GPU3D.RenderPolygonRAM[i];
@@ -1542,42 +1571,28 @@ void GLRenderer::RenderFrame(GPU& gpu)
             u32 fmt = (texparam >> 26) & 7;
             if (fmt == 0) continue;
 
-            u32 vramaddr = (texparam & 0xFFFF) << 3;
-
-            // уникальность в кадре (vramaddr+texparam+texpal важно!)
-            uint64_t key = (uint64_t)vramaddr
-                        ^ (uint64_t)texparam * 0x9e3779b185ebca87ULL
-                        ^ (uint64_t)p->TexPalette * 0xC2B2AE3D27D4EB4FULL;
-            if (!seenFrame.insert(key).second) continue;
-
-            // декод в RGBA (см. пункт 6)
-            std::vector<uint8_t> rgba; int w=0,h=0; u32 f=0;
-            if (!Decode3DTextureToRGBA(gpu, texparam, p->TexPalette, rgba, w, h, f)) continue;
+            // уникальность в кадре (texparam+texpal важно!)
+            if (!ReplSeen.insert(((u64)p->TexPalette << 32) | texparam).second) continue;
 
-            uint64_t h64 = fnv1a64_quarterTL_rgba(rgba.data(), w, h);
-
-            if (melonDS::TexReplace_ReplaceEnabled()) {
-                if (auto rep = FindOrLoadByHash(h64, f, w, h)) {
-                    BindReplacement(vramaddr, texparam, p->TexPalette, rep);
-                }
+            auto& e = ReplCache.Lookup(gpu, texparam, p->TexPalette);
+            if (ReplCache.WantsRGBA(e)) {
+                // декод в RGBA нужен только дампу/миграции, и только один раз
+                int w=0,h=0; u32 f=0;
+                if (!Decode3DTextureToRGBA(gpu, texparam, p->TexPalette, rgba, w, h, f))
+                    rgba.clear();
+                ReplCache.ConsumeRGBA(e, rgba);
             }
 
-            if (melonDS::TexReplace_DumpEnabled()) {
-                // чтобы не забивать дублями — учти формат/размер в сигнатуре
-                uint64_t sig = h64 ^ (uint64_t(f) << 56)
-                                    ^ (uint64_t(uint16_t(w)) << 32)
-                                    ^ (uint64_t(uint16_t(h)) << 16);
-
-                if (!gSeen3DTex.insert(sig).second) continue;
-
-                char fname[256];
-                std::snprintf(fname, sizeof(fname),
-                            "text_replace/dump/%016llX_fmt%u_%dx%d.png",
-                            (unsigned long long)h64, f, w, h);
-                stbi_write_png(fname, w, h, 4, rgba.data(), w*4);
+            if (replace) {
+                if (auto rep = ReplCache.Resolve(e))
+                {
+                    ReplGLTextures.try_emplace(rep.get(), ReplGLTexture{rep, 0});
+                    ReplBinds.Bind(texparam, p->TexPalette, std::move(rep));
+                }
             }
         }
     }
+    ReplBinds.Publish();
 
     CurShaderID = -1;
 
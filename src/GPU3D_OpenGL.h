@@ -24,6 +24,8 @@
 #include "OpenGLSupport.h"
 #include "TexReplace.h"
 
+#include <unordered_set>
+
 namespace melonDS
 {
 class GPU;
@@ -93,6 +95,22 @@ private:
 
     inline void ApplyReplUniforms(u32 flags, const RendererPolygon* rp) const;
 
+    TexReplaceCache ReplCache;
+    ReplBindTable ReplBinds;
+
+    // GL names of the replacements this renderer has drawn. They're per renderer, as they
+    // belong to its context. Each entry keeps its texture alive until it's evicted,
+    // so the key can't be reused by another texture in the meantime
+    struct ReplGLTexture
+    {
+        std::shared_ptr<ReplacementTex> Tex;
+        GLuint Name;
+    };
+    mutable std::unordered_map<const ReplacementTex*, ReplGLTexture> ReplGLTextures;
+    GLuint GetOrCreateGLTex(const ReplacementTex* R) const;
+    void ReleaseEvictedReplGLTextures();
+    std::unordered_set<u64> ReplSeen; // дедуп текстур кадра для замены/дампа
+
     GLCompositor CurGLCompositor;
     RendererPolygon PolygonList[2048] {};
 
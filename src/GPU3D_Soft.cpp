@@ -25,7 +25,6 @@
 #include "GPU.h"
 #include <set>
 #include <cmath>
-#include "stb_image_write.h"
 
 #include <unordered_set>
 #include <tuple>       // для std::tie
@@ -112,15 +111,25 @@ SoftRenderer::SoftRenderer() noexcept
     RenderThreadRunning = false;
     RenderThreadRendering = false;
     RenderThread = nullptr;
+
+    Sema_RasterStart = Platform::Semaphore_Create();
+    Sema_RasterDone = Platform::Semaphore_Create();
+    ScanlineDoneLock = Platform::Mutex_Create();
+    RasterWorkersRunning = false;
 }
 
 SoftRenderer::~SoftRenderer()
 {
     StopRenderThread();
+    StopRasterWorkers();
 
     Platform::Semaphore_Free(Sema_RenderStart);
     Platform::Semaphore_Free(Sema_RenderDone);
     Platform::Semaphore_Free(Sema_ScanlineCount);
+
+    Platform::Semaphore_Free(Sema_RasterStart);
+    Platform::Semaphore_Free(Sema_RasterDone);
+    Platform::Mutex_Free(ScanlineDoneLock);
 }
 
 void SoftRenderer::Reset(GPU& gpu)
@@ -129,7 +138,9 @@ void SoftRenderer::Reset(GPU& gpu)
     memset(DepthBuffer, 0, BufferSize * 2 * 4);
     memset(AttrBuffer, 0, BufferSize * 2 * 4);
 
-    PrevIsShadowMask = false;
+    MainRaster.PrevIsShadowMask = false;
+
+    ReplCache.Reset();
 
     SetupRenderThread(gpu);
     EnableRenderThread();
@@ -145,6 +156,74 @@ void SoftRenderer::SetThreaded(bool threaded, GPU& gpu) noexcept
     }
 }
 
+void SoftRenderer::SetRasterThreads(int count, GPU& gpu) noexcept
+{
+    count = std::clamp(count, 1, MaxRasterThreads);
+    if (RasterThreads != count)
+    {
+        // the workers can only be replaced between frames
+        SetupRenderThread(gpu);
+
+        StopRasterWorkers();
+        RasterThreads = count;
+        StartRasterWorkers();
+
+        EnableRenderThread();
+    }
+}
+
+void SoftRenderer::StartRasterWorkers()
+{
+    if (RasterThreads < 2) return;
+
+    RasterWorkersRunning = true;
+    for (int i = 0; i < RasterThreads; i++)
+    {
+        auto worker = std::make_unique<RasterWorker>();
+        worker->Polygons = std::make_unique<RendererPolygon[]>(2048);
+        worker->Context.Polygons = worker->Polygons.get();
+
+        // the first one is used by the thread that renders the frame
+        if (i > 0)
+            worker->Thread = Platform::Thread_Create([this, i]() { RasterWorkerFunc(i); });
+
+        RasterWorkers.push_back(std::move(worker));
+    }
+}
+
+void SoftRenderer::StopRasterWorkers()
+{
+    if (RasterWorkersRunning.load(std::memory_order_relaxed))
+    {
+        RasterWorkersRunning = false;
+        Platform::Semaphore_Post(Sema_RasterStart, RasterWorkers.size() - 1);
+
+        for (auto& worker : RasterWorkers)
+        {
+            if (!worker->Thread) continue;
+            Platform::Thread_Wait(worker->Thread);
+            Platform::Thread_Free(worker->Thread);
+        }
+    }
+
+    RasterWorkers.clear();
+    Platform::Semaphore_Reset(Sema_RasterStart);
+    Platform::Semaphore_Reset(Sema_RasterDone);
+}
+
+void SoftRenderer::RasterWorkerFunc(int id)
+{
+    for (;;)
+    {
+        Platform::Semaphore_Wait(Sema_RasterStart);
+        if (!RasterWorkersRunning) return;
+
+        RasterChunks(RasterWorkers[id]->Context);
+
+        Platform::Semaphore_Post(Sema_RasterDone);
+    }
+}
+
 void SoftRenderer::TextureLookup(const GPU& gpu, u32 texparam, u32 texpal, s16 s, s16 t, u16* color, u8* alpha) const
 {
     u32 vramaddr = (texparam & 0xFFFF) << 3;
@@ -460,7 +539,7 @@ u32 SoftRenderer::AlphaBlend(const GPU3D& gpu3d, u32 srccolor, u32 dstcolor, u32
 
 u32 SoftRenderer::RenderPixel(const GPU& gpu, const Polygon* polygon,
                               u8 vr, u8 vg, u8 vb, s16 s, s16 t,
-                              const ReplacementTex* repl) const
+                              const ReplMipLevel* repl) const
 {
     u8 r, g, b, a;
 
@@ -530,19 +609,18 @@ u32 SoftRenderer::RenderPixel(const GPU& gpu, const Polygon* polygon,
             si = wrap(si, w, wrapS, mirrorS);
             ti = wrap(ti, h, wrapT, mirrorT);
 
-            // --- маппинг в hi-res (nearest по центрам DS-текселей) ---
-            int rx = (int)std::lround((si + 0.5f) * repl->sx - 0.5f);
-            int ry = (int)std::lround((ti + 0.5f) * repl->sy - 0.5f);
-            if (rx < 0) rx = 0; if (ry < 0) ry = 0;
+            // --- маппинг в выбранный mip-уровень (nearest по центрам DS-текселей) ---
+            int rx = (int)((si + 0.5f) * repl->sx);
+            int ry = (int)((ti + 0.5f) * repl->sy);
             if (rx >= repl->w) rx = repl->w - 1;
             if (ry >= repl->h) ry = repl->h - 1;
 
-            const uint8_t* px = &repl->rgba[(ry * repl->w + rx) * 4];
-            // 8bit -> 6bit как в пайплайне рендера
-            tr = (uint8_t)((px[0] * 63 + 127) / 255);
-            tg = (uint8_t)((px[1] * 63 + 127) / 255);
-            tb = (uint8_t)((px[2] * 63 + 127) / 255);
-            talpha = (uint8_t)((px[3] * 31 + 127) / 255);
+            // тексели уровня уже в 6/5 бит
+            u32 texel = repl->Fetch(rx, ry);
+            tr = texel & 0x3F;
+            tg = (texel >> 8) & 0x3F;
+            tb = (texel >> 16) & 0x3F;
+            talpha = texel >> 24;
 
             usedRepl = true;
         }
@@ -766,7 +844,7 @@ void SoftRenderer::SetupPolygon(SoftRenderer::RendererPolygon* rp, Polygon* poly
     }
 }
 
-void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon* rp, s32 y)
+void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RasterContext& ctx, RendererPolygon* rp, s32 y)
 {
     Polygon* polygon = rp->PolyData;
 
@@ -784,10 +862,10 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
     else
         fnDepthTest = DepthTest_LessThan;
 
-    if (!PrevIsShadowMask)
-        memset(&StencilBuffer[256 * (y&0x1)], 0, 256);
+    if (!ctx.PrevIsShadowMask)
+        memset(&ctx.StencilBuffer[256 * (y&0x1)], 0, 256);
 
-    PrevIsShadowMask = true;
+    ctx.PrevIsShadowMask = true;
 
     if (polygon->YTop != polygon->YBottom)
     {
@@ -928,13 +1006,13 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
         u32 dstattr = AttrBuffer[pixeladdr];
 
         if (!fnDepthTest(DepthBuffer[pixeladdr], z, dstattr))
-            StencilBuffer[256*(y&0x1) + x] = 1;
+            ctx.StencilBuffer[256*(y&0x1) + x] = 1;
 
         if (dstattr & 0xF)
         {
             pixeladdr += BufferSize;
             if (!fnDepthTest(DepthBuffer[pixeladdr], z, AttrBuffer[pixeladdr]))
-                StencilBuffer[256*(y&0x1) + x] |= 0x2;
+                ctx.StencilBuffer[256*(y&0x1) + x] |= 0x2;
         }
     }
 
@@ -954,13 +1032,13 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
         u32 dstattr = AttrBuffer[pixeladdr];
 
         if (!fnDepthTest(DepthBuffer[pixeladdr], z, dstattr))
-            StencilBuffer[256*(y&0x1) + x] = 1;
+            ctx.StencilBuffer[256*(y&0x1) + x] = 1;
 
         if (dstattr & 0xF)
         {
             pixeladdr += BufferSize;
             if (!fnDepthTest(DepthBuffer[pixeladdr], z, AttrBuffer[pixeladdr]))
-                StencilBuffer[256*(y&0x1) + x] |= 0x2;
+                ctx.StencilBuffer[256*(y&0x1) + x] |= 0x2;
         }
     }
 
@@ -980,13 +1058,13 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
         u32 dstattr = AttrBuffer[pixeladdr];
 
         if (!fnDepthTest(DepthBuffer[pixeladdr], z, dstattr))
-            StencilBuffer[256*(y&0x1) + x] = 1;
+            ctx.StencilBuffer[256*(y&0x1) + x] = 1;
 
         if (dstattr & 0xF)
         {
             pixeladdr += BufferSize;
             if (!fnDepthTest(DepthBuffer[pixeladdr], z, AttrBuffer[pixeladdr]))
-                StencilBuffer[256*(y&0x1) + x] |= 0x2;
+                ctx.StencilBuffer[256*(y&0x1) + x] |= 0x2;
         }
     }
 
@@ -994,7 +1072,7 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
     rp->XR = rp->SlopeR.Step();
 }
 
-void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s32 y)
+void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RasterContext& ctx, RendererPolygon* rp, s32 y)
 {
     Polygon* polygon = rp->PolyData;
 
@@ -1012,7 +1090,7 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
     else
         fnDepthTest = DepthTest_LessThan;
 
-    PrevIsShadowMask = false;
+    ctx.PrevIsShadowMask = false;
 
     if (polygon->YTop != polygon->YBottom)
     {
@@ -1180,7 +1258,7 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         // check stencil buffer for shadows
         if (polygon->IsShadow)
         {
-            u8 stencil = StencilBuffer[256*(y&0x1) + x];
+            u8 stencil = ctx.StencilBuffer[256*(y&0x1) + x];
             if (!stencil)
                 continue;
             if (!(stencil & 0x1))
@@ -1212,7 +1290,7 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         s16 s = interpX.Interpolate(sl, sr);
         s16 t = interpX.Interpolate(tl, tr);
 
-        u32 color = RenderPixel(gpu, polygon, vr>>3, vg>>3, vb>>3, s, t, rp->ReplTex);
+        u32 color = RenderPixel(gpu, polygon, vr>>3, vg>>3, vb>>3, s, t, rp->ReplMip);
         u8 alpha = color >> 24;
 
         // alpha test
@@ -1276,7 +1354,7 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         // check stencil buffer for shadows
         if (polygon->IsShadow)
         {
-            u8 stencil = StencilBuffer[256*(y&0x1) + x];
+            u8 stencil = ctx.StencilBuffer[256*(y&0x1) + x];
             if (!stencil)
                 continue;
             if (!(stencil & 0x1))
@@ -1308,7 +1386,7 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         s16 s = interpX.Interpolate(sl, sr);
         s16 t = interpX.Interpolate(tl, tr);
 
-        u32 color = RenderPixel(gpu, polygon, vr>>3, vg>>3, vb>>3, s, t, rp->ReplTex);
+        u32 color = RenderPixel(gpu, polygon, vr>>3, vg>>3, vb>>3, s, t, rp->ReplMip);
         u8 alpha = color >> 24;
 
         // alpha test
@@ -1368,7 +1446,7 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         // check stencil buffer for shadows
         if (polygon->IsShadow)
         {
-            u8 stencil = StencilBuffer[256*(y&0x1) + x];
+            u8 stencil = ctx.StencilBuffer[256*(y&0x1) + x];
             if (!stencil)
                 continue;
             if (!(stencil & 0x1))
@@ -1400,7 +1478,7 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         s16 s = interpX.Interpolate(sl, sr);
         s16 t = interpX.Interpolate(tl, tr);
 
-        u32 color = RenderPixel(gpu, polygon, vr>>3, vg>>3, vb>>3, s, t, rp->ReplTex);
+        u32 color = RenderPixel(gpu, polygon, vr>>3, vg>>3, vb>>3, s, t, rp->ReplMip);
         u8 alpha = color >> 24;
 
         // alpha test
@@ -1452,19 +1530,19 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
     rp->XR = rp->SlopeR.Step();
 }
 
-void SoftRenderer::RenderScanline(const GPU& gpu, s32 y, int npolys)
+void SoftRenderer::RenderScanline(const GPU& gpu, RasterContext& ctx, s32 y, int npolys)
 {
     for (int i = 0; i < npolys; i++)
     {
-        RendererPolygon* rp = &PolygonList[i];
+        RendererPolygon* rp = &ctx.Polygons[i];
         Polygon* polygon = rp->PolyData;
 
         if (y >= polygon->YTop && (y < polygon->YBottom || (y == polygon->YTop && polygon->YBottom == polygon->YTop)))
         {
             if (polygon->IsShadowMask)
-                RenderShadowMaskScanline(gpu.GPU3D, rp, y);
+                RenderShadowMaskScanline(gpu.GPU3D, ctx, rp, y);
             else
-                RenderPolygonScanline(gpu, rp, y);
+                RenderPolygonScanline(gpu, ctx, rp, y);
         }
     }
 }
@@ -1514,6 +1592,11 @@ void SoftRenderer::ScanlineFinalPass(const GPU3D& gpu3d, s32 y)
     // clearing all polygon fog flags if the master flag isn't set?
     // merging all final pass loops into one?
 
+    // edge marking breaks the antialiasing coverage of the pixels it touches
+    // that is kept here rather than in the attribute buffer, as this scanline's
+    // attributes may be read by its neighbours' final pass on another thread
+    u32 edgecoverage[256 / 32] = {};
+
     if (gpu3d.RenderDispCnt & (1<<5))
     {
         // edge marking
@@ -1542,7 +1625,7 @@ void SoftRenderer::ScanlineFinalPass(const GPU3D& gpu3d, s32 y)
                 ColorBuffer[pixeladdr] = edgeR | (edgeG << 8) | (edgeB << 16) | (ColorBuffer[pixeladdr] & 0xFF000000);
 
                 // break antialiasing coverage (checkme)
-                AttrBuffer[pixeladdr] = (AttrBuffer[pixeladdr] & 0xFFFFE0FF) | 0x00001000;
+                edgecoverage[x >> 5] |= (1 << (x & 0x1F));
             }
         }
     }
@@ -1640,6 +1723,7 @@ void SoftRenderer::ScanlineFinalPass(const GPU3D& gpu3d, s32 y)
             if (!(attr & 0xF)) continue;
 
             u32 coverage = (attr >> 8) & 0x1F;
+            if (edgecoverage[x >> 5] & (1 << (x & 0x1F))) coverage = 0x10;
             if (coverage == 0x1F) continue;
 
             if (coverage == 0)
@@ -1817,37 +1901,40 @@ bool SoftRenderer::Decode3DTextureToRGBA(const GPU& gpu,
     return true;
 }
 
+// Во сколько раз полигон уменьшает текстуру: sqrt(площадь в DS-текселях / площадь на экране).
+// Нужно только для выбора mip-уровня замены.
+static float TexelsPerPixel(const Polygon* polygon)
+{
+    float screenArea = 0, texArea = 0;
+    const Vertex* v0 = polygon->Vertices[0];
+    for (u32 i = 1; i + 1 < polygon->NumVertices; i++)
+    {
+        const Vertex* v1 = polygon->Vertices[i];
+        const Vertex* v2 = polygon->Vertices[i+1];
+
+        screenArea += std::abs((float)(v1->FinalPosition[0] - v0->FinalPosition[0]) * (v2->FinalPosition[1] - v0->FinalPosition[1])
+                             - (float)(v2->FinalPosition[0] - v0->FinalPosition[0]) * (v1->FinalPosition[1] - v0->FinalPosition[1]));
+        texArea += std::abs((float)(v1->TexCoords[0] - v0->TexCoords[0]) * (v2->TexCoords[1] - v0->TexCoords[1])
+                          - (float)(v2->TexCoords[0] - v0->TexCoords[0]) * (v1->TexCoords[1] - v0->TexCoords[1]));
+    }
+
+    if (screenArea < 1.0f) return 1.0f;
+    return std::sqrt(texArea / (256.0f * screenArea)); // TexCoords в 12.4
+}
+
 void SoftRenderer::RenderPolygons(const GPU& gpu, bool threaded, Polygon** polygons, int npolys)
 {
     GPU& ngpu = const_cast<GPU&>(gpu);
-    auto texDirty = ngpu.VRAMDirty_Texture.DeriveState(ngpu.VRAMMap_Texture, ngpu);
-    auto palDirty = ngpu.VRAMDirty_TexPal.DeriveState(ngpu.VRAMMap_TexPal, ngpu);
-    ngpu.MakeVRAMFlat_TextureCoherent(texDirty);
-    ngpu.MakeVRAMFlat_TexPalCoherent(palDirty);
-
-    ClearBindings();
 
     // ---- PASS 1: уникальные текстуры кадра -> поиск замены + (опц.) дамп
-    struct Key {
-        u32 vram, texparam, texpal;
-        bool operator==(const Key& o) const noexcept {
-            return vram==o.vram && texparam==o.texparam && texpal==o.texpal;
-        }
-    };
-    struct KeyHash {
-        size_t operator()(const Key& k) const noexcept {
-            uint64_t h=1469598103934665603ULL;
-            auto mix=[&](u32 v){ h^=v; h*=1099511628211ULL; };
-            mix(k.vram); mix(k.texparam); mix(k.texpal);
-            return (size_t)h;
-        }
-    };
+    // Хэш VRAM — только для текстур, которых ещё нет в ReplCache (или чья VRAM изменилась).
+    const bool replace = melonDS::TexReplace_ReplaceEnabled();
+    const bool wantRGBA = melonDS::TexReplace_DumpEnabled() || melonDS::TexReplace_MigrateEnabled();
 
-    std::unordered_set<Key, KeyHash> seen;
-    seen.reserve(npolys*2);
-
-    if (melonDS::TexReplace_ReplaceEnabled() || melonDS::TexReplace_DumpEnabled()) {
-        EnsureDump3DDir(); // если дамп включён, позаботься о каталоге
+    ReplBinds.Begin();
+    if (replace || wantRGBA) {
+        ReplSeen.clear();
+        std::vector<uint8_t> rgba;
 
         for (int i = 0; i < npolys; ++i) {
             Polygon* p = polygons[i];
@@ -1857,62 +1944,56 @@ void SoftRenderer::RenderPolygons(const GPU& gpu, bool threaded, Polygon** polyg
             u32 fmt = (texparam >> 26) & 7;
             if (fmt == 0) continue;
 
-            u32 vramaddr = (texparam & 0xFFFF) << 3;
-            Key k{ vramaddr, texparam, p->TexPalette };
-            if (!seen.insert(k).second) continue; // дедуп в кадре
-
-            std::vector<uint8_t> rgba;
-            int w=0,h=0; u32 f=0;
-            if (!Decode3DTextureToRGBA(gpu, texparam, p->TexPalette, rgba, w, h, f))
-                continue;
+            if (!ReplSeen.insert(((u64)p->TexPalette << 32) | texparam).second) continue; // дедуп в кадре
 
-            uint64_t h64 = fnv1a64_quarterTL_rgba(rgba.data(), w, h);
-
-            if (melonDS::TexReplace_ReplaceEnabled()) {
-                if (auto R = FindOrLoadByHash(h64, f, w, h)) {
-                    BindReplacement(vramaddr, texparam, p->TexPalette, R);
-                }
+            auto& e = ReplCache.Lookup(gpu, texparam, p->TexPalette);
+            if (ReplCache.WantsRGBA(e)) {
+                // декод в RGBA нужен только дампу/миграции, и только один раз
+                int w=0,h=0; u32 f=0;
+                if (!Decode3DTextureToRGBA(gpu, texparam, p->TexPalette, rgba, w, h, f))
+                    rgba.clear();
+                ReplCache.ConsumeRGBA(e, rgba);
             }
 
-            if (melonDS::TexReplace_DumpEnabled()) {
-                uint64_t sig = h64
-                             ^ (uint64_t(f) << 56)
-                             ^ (uint64_t((u16)w) << 32)
-                             ^ (uint64_t((u16)h) << 16);
-                if (gSeen3DTex.insert(sig).second) {
-                    char fname[256];
-                    std::snprintf(fname, sizeof(fname),
-                        "text_replace/dump/%016llX_fmt%u_%dx%d.png",
-                        (unsigned long long)h64, f, w, h);
-                    stbi_write_png(fname, w, h, 4, rgba.data(), w*4);
-                }
+            if (replace) {
+                if (auto R = ReplCache.Resolve(e))
+                    ReplBinds.Bind(texparam, p->TexPalette, std::move(R));
             }
         }
     }
+    ReplBinds.Publish();
 
     // ---- PASS 2: собираем PolygonList и проставляем ReplTex
     int count = 0;
+    bool shadowmasks = false;
     for (int i = 0; i < npolys; ++i) {
         if (polygons[i]->Degenerate) continue;
+        if (polygons[i]->IsShadowMask) shadowmasks = true;
 
         SetupPolygon(&PolygonList[count], polygons[i]);
 
-        u32 texparam = polygons[i]->TexParam;
-        u32 vramaddr = (texparam & 0xFFFF) << 3;
-        if (melonDS::TexReplace_ReplaceEnabled()) {
-            auto R = GetBound(vramaddr, texparam, polygons[i]->TexPalette);
-            PolygonList[count].ReplTex = R ? R.get() : nullptr;
-        } else {
-            PolygonList[count].ReplTex = nullptr;
-        }
+        // без локов: снимок привязок опубликован в PASS 1
+        const ReplacementTex* R = replace
+            ? ReplBinds.Lookup(polygons[i]->TexParam, polygons[i]->TexPalette)
+            : nullptr;
+        PolygonList[count].ReplTex = R;
+        PolygonList[count].ReplMip = R ? R->PickMip(TexelsPerPixel(polygons[i])) : nullptr;
 
         ++count;
     }
 
     // ---- рендер
-    RenderScanline(gpu, 0, count);
+    // shadow masks may leave the stencil buffer of one scanline to the next ones
+    // with the same parity, so scanlines can't be rendered independently then
+    if (RasterWorkersRunning.load(std::memory_order_relaxed) && !shadowmasks)
+    {
+        RenderPolygonsParallel(gpu, threaded, count);
+        return;
+    }
+
+    RenderScanline(gpu, MainRaster, 0, count);
     for (s32 y = 1; y < 192; y++) {
-        RenderScanline(gpu, y, count);
+        RenderScanline(gpu, MainRaster, y, count);
         ScanlineFinalPass(gpu.GPU3D, y-1);
         if (threaded) Platform::Semaphore_Post(Sema_ScanlineCount);
     }
@@ -1921,6 +2002,110 @@ void SoftRenderer::RenderPolygons(const GPU& gpu, bool threaded, Polygon** polyg
     if (threaded) Platform::Semaphore_Post(Sema_ScanlineCount);
 }
 
+void SoftRenderer::RenderPolygonsParallel(const GPU& gpu, bool threaded, int npolys)
+{
+    RasterGPU = &gpu;
+    RasterNumPolygons = npolys;
+    RasterPostScanlines = threaded;
+    RasterNextChunk = 0;
+
+    for (int i = 0; i < 192; i++)
+    {
+        ScanlineRasterized[i].store(false, std::memory_order_relaxed);
+        ScanlineFinalClaimed[i].store(false, std::memory_order_relaxed);
+        ScanlineDone[i] = false;
+    }
+    NumScanlinesDone = 0;
+
+    // without shadow masks nothing writes to the stencil buffer, shadow polygons
+    // all see what the previous frame left there
+    for (auto& worker : RasterWorkers)
+    {
+        memcpy(worker->Context.StencilBuffer, MainRaster.StencilBuffer, sizeof(MainRaster.StencilBuffer));
+        worker->Context.PrevIsShadowMask = MainRaster.PrevIsShadowMask;
+    }
+
+    Platform::Semaphore_Post(Sema_RasterStart, RasterWorkers.size() - 1);
+    RasterChunks(RasterWorkers[0]->Context);
+    for (size_t i = 1; i < RasterWorkers.size(); i++)
+        Platform::Semaphore_Wait(Sema_RasterDone);
+
+    // any polygon drawn clears this, as it would have serially
+    for (auto& worker : RasterWorkers)
+        MainRaster.PrevIsShadowMask &= worker->Context.PrevIsShadowMask;
+}
+
+void SoftRenderer::RasterChunks(RasterContext& ctx)
+{
+    const GPU& gpu = *RasterGPU;
+
+    for (;;)
+    {
+        int chunk = RasterNextChunk.fetch_add(1);
+        if (chunk >= NumRasterChunks) break;
+
+        s32 ystart = chunk * RasterChunkLines;
+        s32 yend = ystart + RasterChunkLines;
+
+        // take the polygons covering this chunk, in order, with their edges
+        // set up as they would be after rendering all the scanlines above
+        int npolys = 0;
+        for (int i = 0; i < RasterNumPolygons; i++)
+        {
+            Polygon* polygon = PolygonList[i].PolyData;
+            if (polygon->YTop == polygon->YBottom)
+            {
+                if (polygon->YTop < ystart || polygon->YTop >= yend)
+                    continue;
+            }
+            else if (polygon->YTop >= yend || polygon->YBottom <= ystart)
+                continue;
+
+            RendererPolygon* rp = &ctx.Polygons[npolys++];
+            *rp = PolygonList[i];
+
+            if (polygon->YTop < ystart && polygon->YTop != polygon->YBottom)
+            {
+                SetupPolygonLeftEdge(rp, ystart);
+                SetupPolygonRightEdge(rp, ystart);
+            }
+        }
+
+        for (s32 y = ystart; y < yend; y++)
+        {
+            RenderScanline(gpu, ctx, y, npolys);
+            ScanlineRasterized[y] = true;
+
+            TryScanlineFinalPass(y-1);
+        }
+
+        // the scanlines at the chunk boundaries also wait for the neighbouring chunks
+        TryScanlineFinalPass(yend-1);
+        TryScanlineFinalPass(yend);
+    }
+}
+
+void SoftRenderer::TryScanlineFinalPass(s32 y)
+{
+    if (y < 0 || y >= 192) return;
+
+    if (!ScanlineRasterized[y]) return;
+    if (y > 0 && !ScanlineRasterized[y-1]) return;
+    if (y < 191 && !ScanlineRasterized[y+1]) return;
+    if (ScanlineFinalClaimed[y].exchange(true)) return;
+
+    ScanlineFinalPass(RasterGPU->GPU3D, y);
+
+    Platform::Mutex_Lock(ScanlineDoneLock);
+    ScanlineDone[y] = true;
+    while (NumScanlinesDone < 192 && ScanlineDone[NumScanlinesDone])
+    {
+        NumScanlinesDone++;
+        if (RasterPostScanlines) Platform::Semaphore_Post(Sema_ScanlineCount);
+    }
+    Platform::Mutex_Unlock(ScanlineDoneLock);
+}
+
 
 void SoftRenderer::VCount144(GPU& gpu)
 {
@@ -1938,6 +2123,11 @@ void SoftRenderer::RenderFrame(GPU& gpu)
 
     FrameIdentical = !(textureChanged || texPalChanged) && gpu.GPU3D.RenderFrameIdentical;
 
+    // the replacement cache is checked against the same dirty state, every frame
+    // (even with replacement off), as the dirty bits are gone once derived
+    ReplCache.Invalidate(gpu, textureChanged ? textureDirty.Data : nullptr,
+                              texPalChanged ? texPalDirty.Data : nullptr, ReplBinds);
+
     if (RenderThreadRunning.load(std::memory_order_relaxed))
     {
         // "Render thread, you're up! Get moving."
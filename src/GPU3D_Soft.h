@@ -23,6 +23,9 @@
 #include "Platform.h"
 #include <thread>
 #include <atomic>
+#include <unordered_set>
+#include <memory>
+#include <vector>
 #include "TexReplace.h"
 
 namespace melonDS
@@ -38,6 +41,13 @@ public:
     void SetThreaded(bool threaded, GPU& gpu) noexcept;
     [[nodiscard]] bool IsThreaded() const noexcept { return Threaded; }
 
+    // number of threads sharing the rasterization of a frame
+    // the extra threads help whoever renders the frame: the render thread
+    // if threaded, the emulator thread otherwise
+    void SetRasterThreads(int count, GPU& gpu) noexcept;
+    [[nodiscard]] int GetRasterThreads() const noexcept { return RasterThreads; }
+    static constexpr int MaxRasterThreads = 16;
+
     void VCount144(GPU& gpu) override;
     void RenderFrame(GPU& gpu) override;
     void RestartFrame(GPU& gpu) override;
@@ -441,27 +451,51 @@ private:
         u32 NextVL, NextVR;
 
         const ReplacementTex* ReplTex = nullptr; // <— новое
+        const ReplMipLevel* ReplMip = nullptr;   // уровень ReplTex, выбранный для этого полигона
     };
 
     RendererPolygon PolygonList[2048];
+
+    // state that carries over from one scanline to the next while rasterizing:
+    // polygon edges, and the stencil buffer used by shadow polygons
+    struct RasterContext
+    {
+        RendererPolygon* Polygons;
+        u8 StencilBuffer[256*2];
+        bool PrevIsShadowMask;
+    };
+
+    RasterContext MainRaster {PolygonList, {}, false};
+
+    TexReplaceCache ReplCache;
+    ReplBindTable ReplBinds;
+    std::unordered_set<u64> ReplSeen; // дедуп текстур в PASS 1, переиспользуется между кадрами
+
     void TextureLookup(const GPU& gpu, u32 texparam, u32 texpal, s16 s, s16 t, u16* color, u8* alpha) const;
     u32 RenderPixel(const GPU& gpu, const Polygon* polygon,
                               u8 vr, u8 vg, u8 vb, s16 s, s16 t,
-                              const ReplacementTex* repl) const;
+                              const ReplMipLevel* repl) const;
     void PlotTranslucentPixel(const GPU3D& gpu3d, u32 pixeladdr, u32 color, u32 z, u32 polyattr, u32 shadow);
     void SetupPolygonLeftEdge(RendererPolygon* rp, s32 y) const;
     void SetupPolygonRightEdge(RendererPolygon* rp, s32 y) const;
     void SetupPolygon(RendererPolygon* rp, Polygon* polygon) const;
-    void RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon* rp, s32 y);
-    void RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s32 y);
-    void RenderScanline(const GPU& gpu, s32 y, int npolys);
+    void RenderShadowMaskScanline(const GPU3D& gpu3d, RasterContext& ctx, RendererPolygon* rp, s32 y);
+    void RenderPolygonScanline(const GPU& gpu, RasterContext& ctx, RendererPolygon* rp, s32 y);
+    void RenderScanline(const GPU& gpu, RasterContext& ctx, s32 y, int npolys);
     u32 CalculateFogDensity(const GPU3D& gpu3d, u32 pixeladdr) const;
     void ScanlineFinalPass(const GPU3D& gpu3d, s32 y);
     void ClearBuffers(const GPU& gpu);
     void RenderPolygons(const GPU& gpu, bool threaded, Polygon** polygons, int npolys);
+    void RenderPolygonsParallel(const GPU& gpu, bool threaded, int npolys);
+    void RasterChunks(RasterContext& ctx);
+    void TryScanlineFinalPass(s32 y);
 
     void RenderThreadFunc(GPU& gpu);
 
+    void StartRasterWorkers();
+    void StopRasterWorkers();
+    void RasterWorkerFunc(int id);
+
     // buffer dimensions are 258x194 to add a offscreen 1px border
     // which simplifies edge marking tests
     // buffer is duplicated to keep track of the two topmost pixels
@@ -486,9 +520,6 @@ private:
     // bit22: translucent flag
     // bit24-29: polygon ID for opaque pixels
 
-    u8 StencilBuffer[256*2];
-    bool PrevIsShadowMask;
-
     bool Enabled;
 
     bool FrameIdentical;
@@ -509,5 +540,43 @@ private:
     // Used to allow the main thread to read some scanlines
     // before (the 3D portion of) the entire frame is rasterized.
     Platform::Semaphore* Sema_ScanlineCount;
+
+    // parallel rasterization
+
+    // the frame is handed out in chunks of scanlines, in order, so the first
+    // lines are finished first and can go to the 2D compositor early
+    static constexpr int RasterChunkLines = 8;
+    static constexpr int NumRasterChunks = 192 / RasterChunkLines;
+
+    struct RasterWorker
+    {
+        RasterContext Context;
+        std::unique_ptr<RendererPolygon[]> Polygons;
+        Platform::Thread* Thread = nullptr;
+    };
+
+    int RasterThreads = 1;
+    // one per thread, the first one belongs to whoever renders the frame
+    std::vector<std::unique_ptr<RasterWorker>> RasterWorkers;
+    std::atomic_bool RasterWorkersRunning;
+
+    // Used to tell the workers to start on a frame, and by them to tell that they're done
+    Platform::Semaphore* Sema_RasterStart;
+    Platform::Semaphore* Sema_RasterDone;
+
+    const GPU* RasterGPU = nullptr;
+    int RasterNumPolygons = 0;
+    bool RasterPostScanlines = false;
+    std::atomic_int RasterNextChunk;
+
+    // the final pass of a scanline needs its neighbours rasterized, it is done
+    // by whichever thread finishes the last of the three
+    std::atomic_bool ScanlineRasterized[192];
+    std::atomic_bool ScanlineFinalClaimed[192];
+
+    // finished scanlines are handed to the main thread in order
+    Platform::Mutex* ScanlineDoneLock;
+    bool ScanlineDone[192];
+    int NumScanlinesDone = 0;
 };
 }
@@ -40,6 +40,120 @@ void ConvertAXIYTexture(u32 width, u32 height, u32* output, u32 addr, u32 palAdd
 template <int outputFmt, int colorBits>
 void ConvertNColorsTexture(u32 width, u32 height, u32* output, u32 addr, u32 palAddr, bool color0Transparent, GPU& gpu);
 
+inline u64 TexcacheMaskedHash(const u8* vram, u32 vramSize, u32 addr, u32 size)
+{
+    u64 hash = 0;
+
+    while (size > 0)
+    {
+        u32 pieceSize;
+        if (addr + size > vramSize)
+            // wraps around, only do the part inside
+            pieceSize = vramSize - addr;
+        else
+            // fits completely inside
+            pieceSize = size;
+
+        hash = XXH64(&vram[addr], pieceSize, hash);
+
+        addr += pieceSize;
+        addr &= (vramSize - 1);
+        assert(size >= pieceSize);
+        size -= pieceSize;
+    }
+
+    return hash;
+}
+
+inline bool TexcacheCheckInvalid(u32 start, u32 size, u64 oldHash, const u64* dirty, const u8* vram, u32 vramSize)
+{
+    u32 startBit = start / VRAMDirtyGranularity;
+    u32 bitsCount = ((start + size + VRAMDirtyGranularity - 1) / VRAMDirtyGranularity) - startBit;
+
+    u32 startEntry = startBit >> 6;
+    u64 entriesCount = ((startBit + bitsCount + 0x3F) >> 6) - startEntry;
+    for (u32 j = startEntry; j < startEntry + entriesCount; j++)
+    {
+        if (GetRangedBitMask(j, startBit, bitsCount) & dirty[j & ((vramSize / VRAMDirtyGranularity)-1)])
+        {
+            if (TexcacheMaskedHash(vram, vramSize, start, size) != oldHash)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// cache key for a texture, ignoring the sampling and texcoord gen params
+inline u64 TexcacheKey(u32 texParam, u32 palBase)
+{
+    texParam &= ~0xC00F0000;
+
+    u32 fmt = (texParam >> 26) & 0x7;
+    u64 key = texParam;
+    if (fmt != 7)
+    {
+        key |= (u64)palBase << 32;
+        if (fmt == 5)
+            key &= ~((u64)1 << 29);
+    }
+    return key;
+}
+
+// the texture and palette memory a texture is decoded from
+struct TextureVRAMRanges
+{
+    u32 TextureRAMStart[2], TextureRAMSize[2];
+    u32 TexPalStart, TexPalSize;
+};
+
+inline TextureVRAMRanges GetTextureVRAMRanges(u32 texParam, u32 palBase)
+{
+    TextureVRAMRanges ranges = {};
+
+    u32 fmt = (texParam >> 26) & 0x7;
+    u32 width = TextureWidth(texParam);
+    u32 height = TextureHeight(texParam);
+    u32 addr = (texParam & 0xFFFF) * 8;
+
+    ranges.TextureRAMStart[0] = addr;
+
+    if (fmt == 7)
+    {
+        ranges.TextureRAMSize[0] = width*height*2;
+    }
+    else if (fmt == 5)
+    {
+        u32 slot1addr = 0x20000 + ((addr & 0x1FFFC) >> 1);
+        if (addr >= 0x40000)
+            slot1addr += 0x10000;
+
+        ranges.TextureRAMSize[0] = width*height/16*4;
+        ranges.TextureRAMStart[1] = slot1addr;
+        ranges.TextureRAMSize[1] = width*height/16*2;
+        ranges.TexPalStart = palBase*16;
+        ranges.TexPalSize = 0x10000;
+    }
+    else
+    {
+        u32 texSize = 0, palAddr = palBase*16, numPalEntries = 0;
+        switch (fmt)
+        {
+        case 1: texSize = width*height; numPalEntries = 32; break;
+        case 6: texSize = width*height; numPalEntries = 8; break;
+        case 2: texSize = width*height/4; numPalEntries = 4; palAddr >>= 1; break;
+        case 3: texSize = width*height/2; numPalEntries = 16; break;
+        case 4: texSize = width*height; numPalEntries = 256; break;
+        }
+
+        ranges.TextureRAMSize[0] = texSize;
+        ranges.TexPalStart = palAddr & 0x1FFFF;
+        ranges.TexPalSize = numPalEntries*2;
+    }
+
+    return ranges;
+}
+
 template <typename TexLoaderT, typename TexHandleT>
 class Texcache
 {
@@ -50,46 +164,12 @@ public:
 
     u64 MaskedHash(u8* vram, u32 vramSize, u32 addr, u32 size)
     {
-        u64 hash = 0;
-
-        while (size > 0)
-        {
-            u32 pieceSize;
-            if (addr + size > vramSize)
-                // wraps around, only do the part inside
-                pieceSize = vramSize - addr;
-            else
-                // fits completely inside
-                pieceSize = size;
-
-            hash = XXH64(&vram[addr], pieceSize, hash);
-
-            addr += pieceSize;
-            addr &= (vramSize - 1);
-            assert(size >= pieceSize);
-            size -= pieceSize;
-        }
-
-        return hash;
+        return TexcacheMaskedHash(vram, vramSize, addr, size);
     }
 
     bool CheckInvalid(u32 start, u32 size, u64 oldHash, u64* dirty, u8* vram, u32 vramSize)
     {
-        u32 startBit = start / VRAMDirtyGranularity;
-        u32 bitsCount = ((start + size + VRAMDirtyGranularity - 1) / VRAMDirtyGranularity) - startBit;
-    
-        u32 startEntry = startBit >> 6;
-        u64 entriesCount = ((startBit + bitsCount + 0x3F) >> 6) - startEntry;
-        for (u32 j = startEntry; j < startEntry + entriesCount; j++)
-        {
-            if (GetRangedBitMask(j, startBit, bitsCount) & dirty[j & ((vramSize / VRAMDirtyGranularity)-1)])
-            {
-                if (MaskedHash(vram, vramSize, start, size) != oldHash)
-                    return true;
-            }
-        }
-
-        return false;
+        return TexcacheCheckInvalid(start, size, oldHash, dirty, vram, vramSize);
     }
 
     bool Update(GPU& gpu)
@@ -149,13 +229,7 @@ public:
         texParam &= ~0xC00F0000;
 
         u32 fmt = (texParam >> 26) & 0x7;
-        u64 key = texParam;
-        if (fmt != 7)
-        {
-            key |= (u64)palBase << 32;
-            if (fmt == 5)
-                key &= ~((u64)1 << 29);
-        }
+        u64 key = TexcacheKey(texParam, palBase);
         //printf("%" PRIx64 " %" PRIx32 " %" PRIx32 "\n", key, texParam, palBase);
 
         assert(fmt != 0 && "no texture is not a texture format!");
@@ -177,54 +251,36 @@ public:
 
         u32 addr = (texParam & 0xFFFF) * 8;
 
+        TextureVRAMRanges ranges = GetTextureVRAMRanges(texParam, palBase);
+
         TexCacheEntry entry = {0};
 
-        entry.TextureRAMStart[0] = addr;
+        for (int i = 0; i < 2; i++)
+        {
+            entry.TextureRAMStart[i] = ranges.TextureRAMStart[i];
+            entry.TextureRAMSize[i] = ranges.TextureRAMSize[i];
+        }
+        entry.TexPalStart = ranges.TexPalStart;
+        entry.TexPalSize = ranges.TexPalSize;
         entry.WidthLog2 = widthLog2;
         entry.HeightLog2 = heightLog2;
 
         // apparently a new texture
         if (fmt == 7)
         {
-            entry.TextureRAMSize[0] = width*height*2;
-
             ConvertBitmapTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, addr, gpu);
         }
         else if (fmt == 5)
         {
-            u32 slot1addr = 0x20000 + ((addr & 0x1FFFC) >> 1);
-            if (addr >= 0x40000)
-                slot1addr += 0x10000;
-
-            entry.TextureRAMSize[0] = width*height/16*4;
-            entry.TextureRAMStart[1] = slot1addr;
-            entry.TextureRAMSize[1] = width*height/16*2;
-            entry.TexPalStart = palBase*16;
-            entry.TexPalSize = 0x10000;
-
-            ConvertCompressedTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, addr, slot1addr, entry.TexPalStart, gpu);
+            ConvertCompressedTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, addr, entry.TextureRAMStart[1], entry.TexPalStart, gpu);
         }
         else
         {
-            u32 texSize, palAddr = palBase*16, numPalEntries;
-            switch (fmt)
-            {
-            case 1: texSize = width*height; numPalEntries = 32; break;
-            case 6: texSize = width*height; numPalEntries = 8; break;
-            case 2: texSize = width*height/4; numPalEntries = 4; palAddr >>= 1; break;
-            case 3: texSize = width*height/2; numPalEntries = 16; break;
-            case 4: texSize = width*height; numPalEntries = 256; break;
-            }
-
-            palAddr &= 0x1FFFF;
+            u32 palAddr = entry.TexPalStart;
 
             /*printf("creating texture | fmt: %d | %dx%d | %08x | %08x\n", fmt, width, height, addr, palAddr);
             svcSleepThread(1000*1000);*/
 
-            entry.TextureRAMSize[0] = texSize;
-            entry.TexPalStart = palAddr;
-            entry.TexPalSize = numPalEntries*2;
-
             //assert(entry.TexPalStart+entry.TexPalSize <= 128*1024*1024);
 
             bool color0Transparent = texParam & (1 << 29);
@@ -19,24 +19,20 @@
 #ifndef MELONDS_JITBLOCK_H
 #define MELONDS_JITBLOCK_H
 
+#include <memory>
+#include <vector>
+#include <assert.h>
 #include "types.h"
-#include "TinyVector.h"
 
 namespace melonDS
 {
 typedef void (*JitBlockEntry)();
 
+// blocks are allocated from a JitBlockArena, with the address ranges,
+// masks and literals stored directly behind them
 class JitBlock
 {
 public:
-    JitBlock(u32 num, u32 literalHash, u32 numAddresses, u32 numLiterals)
-    {
-        Num = num;
-        NumAddresses = numAddresses;
-        NumLiterals = numLiterals;
-        Data.SetLength(numAddresses * 2 + numLiterals);
-    }
-
     u32 StartAddr;
     u32 StartAddrLocal;
     u32 InstrHash, LiteralHash;
@@ -46,15 +42,172 @@ public:
 
     JitBlockEntry EntryPoint;
 
-    const u32* AddressRanges() const { return &Data[0]; }
-    u32* AddressRanges() { return &Data[0]; }
-    const u32* AddressMasks() const { return &Data[NumAddresses]; }
-    u32* AddressMasks() { return &Data[NumAddresses]; }
-    const u32* Literals() const { return &Data[NumAddresses * 2]; }
-    u32* Literals() { return &Data[NumAddresses * 2]; }
+    const u32* AddressRanges() const { return Data(); }
+    u32* AddressRanges() { return Data(); }
+    const u32* AddressMasks() const { return Data() + NumAddresses; }
+    u32* AddressMasks() { return Data() + NumAddresses; }
+    const u32* Literals() const { return Data() + NumAddresses * 2; }
+    u32* Literals() { return Data() + NumAddresses * 2; }
+
+private:
+    friend class JitBlockArena;
+    friend class JitBlockDirectory;
+
+    // other blocks starting at the same local address (at different mirrors)
+    JitBlock* NextInSlot;
+    // all blocks of a directory, for walking over them
+    JitBlock* PrevLive;
+    JitBlock* NextLive;
+    u8 SizeClass;
+
+    const u32* Data() const { return reinterpret_cast<const u32*>(this + 1); }
+    u32* Data() { return reinterpret_cast<u32*>(this + 1); }
+};
+
+// Bump allocator with a free list per size class. Everything
+// is given back at once when the block cache is reset.
+class JitBlockArena
+{
+public:
+    JitBlock* Allocate(u32 num, u32 numAddresses, u32 numLiterals)
+    {
+        u32 words = numAddresses * 2 + numLiterals;
+        u32 sizeClass = (words + WordsPerClass - 1) / WordsPerClass;
+        assert(sizeClass < NumSizeClasses);
+
+        JitBlock* block = FreeLists[sizeClass];
+        if (block)
+        {
+            FreeLists[sizeClass] = block->NextLive;
+        }
+        else
+        {
+            u32 size = sizeof(JitBlock) + sizeClass * WordsPerClass * sizeof(u32);
+            if (ChunkUsed + size > ChunkSize)
+            {
+                CurChunk++;
+                ChunkUsed = 0;
+            }
+            if (CurChunk == Chunks.size())
+                Chunks.emplace_back(new u8[ChunkSize]);
+
+            block = reinterpret_cast<JitBlock*>(&Chunks[CurChunk][ChunkUsed]);
+            ChunkUsed += size;
+        }
+
+        block->Num = num;
+        block->NumAddresses = numAddresses;
+        block->NumLiterals = numLiterals;
+        block->SizeClass = sizeClass;
+        block->NextInSlot = nullptr;
+        block->PrevLive = block->NextLive = nullptr;
+        return block;
+    }
+
+    void Free(JitBlock* block)
+    {
+        block->NextLive = FreeLists[block->SizeClass];
+        FreeLists[block->SizeClass] = block;
+    }
+
+    // invalidates all blocks, the memory is kept for reuse
+    void Reset()
+    {
+        CurChunk = 0;
+        ChunkUsed = 0;
+        for (int i = 0; i < NumSizeClasses; i++)
+            FreeLists[i] = nullptr;
+    }
+
+private:
+    static constexpr u32 ChunkSize = 256 * 1024;
+    static constexpr u32 WordsPerClass = 8;
+    // up to 32 address ranges and 32 literals
+    static constexpr int NumSizeClasses = (32 * 3 + WordsPerClass - 1) / WordsPerClass + 1;
+
+    std::vector<std::unique_ptr<u8[]>> Chunks;
+    size_t CurChunk = 0;
+    u32 ChunkUsed = 0;
+    JitBlock* FreeLists[NumSizeClasses] {};
+};
+
+// Blocks of one cpu indexed by their local start address (see ARMJIT::LocaliseCodeAddress).
+// Like the code indices it's split by memory region, each of them
+// being divided into pages which are only allocated once they contain a block.
+class JitBlockDirectory
+{
+public:
+    JitBlock* Find(u32 localAddr, u32 startAddr) const
+    {
+        const std::vector<std::unique_ptr<Page>>& pages = Regions[localAddr >> 27];
+        u32 pageIdx = (localAddr & 0x7FFFFFF) >> PageShift;
+        if (pageIdx >= pages.size() || !pages[pageIdx])
+            return nullptr;
+
+        JitBlock* block = pages[pageIdx]->Slots[(localAddr & PageMask) / 2];
+        while (block && block->StartAddr != startAddr)
+            block = block->NextInSlot;
+        return block;
+    }
+
+    void Insert(JitBlock* block)
+    {
+        std::vector<std::unique_ptr<Page>>& pages = Regions[block->StartAddrLocal >> 27];
+        u32 pageIdx = (block->StartAddrLocal & 0x7FFFFFF) >> PageShift;
+        if (pageIdx >= pages.size())
+            pages.resize(pageIdx + 1);
+        if (!pages[pageIdx])
+            pages[pageIdx] = std::make_unique<Page>();
+
+        JitBlock*& slot = pages[pageIdx]->Slots[(block->StartAddrLocal & PageMask) / 2];
+        block->NextInSlot = slot;
+        slot = block;
+
+        block->PrevLive = nullptr;
+        block->NextLive = LiveHead;
+        if (LiveHead)
+            LiveHead->PrevLive = block;
+        LiveHead = block;
+    }
+
+    void Remove(JitBlock* block)
+    {
+        std::vector<std::unique_ptr<Page>>& pages = Regions[block->StartAddrLocal >> 27];
+        JitBlock** slot = &pages[(block->StartAddrLocal & 0x7FFFFFF) >> PageShift]->Slots[(block->StartAddrLocal & PageMask) / 2];
+        while (*slot != block)
+            slot = &(*slot)->NextInSlot;
+        *slot = block->NextInSlot;
+
+        if (block->PrevLive)
+            block->PrevLive->NextLive = block->NextLive;
+        else
+            LiveHead = block->NextLive;
+        if (block->NextLive)
+            block->NextLive->PrevLive = block->PrevLive;
+    }
+
+    void Clear()
+    {
+        for (auto& pages : Regions)
+            pages.clear();
+        LiveHead = nullptr;
+    }
+
+    // blocks may be removed while walking over them, as long as the next one is fetched first
+    JitBlock* First() const { return LiveHead; }
+    static JitBlock* Next(const JitBlock* block) { return block->NextLive; }
 
 private:
-    TinyVector<u32> Data;
+    static constexpr u32 PageShift = 12;
+    static constexpr u32 PageMask = (1 << PageShift) - 1;
+
+    struct Page
+    {
+        JitBlock* Slots[(1 << PageShift) / 2] {};
+    };
+
+    std::vector<std::unique_ptr<Page>> Regions[32];
+    JitBlock* LiveHead = nullptr;
 };
 }
 
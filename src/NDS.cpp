@@ -182,6 +182,11 @@ void NDS::SetARM9RegionTimings(u32 addrstart, u32 addrend, u32 region, int buswi
 
 void NDS::SetARM7RegionTimings(u32 addrstart, u32 addrend, u32 region, int buswidth, int nonseq, int seq)
 {
+#ifdef JIT_ENABLED
+    // compiled code has the timings baked in
+    JIT.WaitForCompileThread();
+#endif
+
     addrstart >>= 3;
     addrend   >>= 3;
 
@@ -621,6 +626,10 @@ bool NDS::DoSavestate(Savestate* file)
     }
     else
     {
+#ifdef JIT_ENABLED
+        // everything the compile thread might be looking at is about to be replaced
+        JIT.WaitForCompileThread();
+#endif
         u32 console;
         file->Var32(&console);
         if (console != ConsoleType)
@@ -837,6 +846,7 @@ void NDS::RunSystem(u64 timestamp)
             {
                 SchedListMask &= ~(1<<i);
 
+                PROFILE_EVENT(Profiler, i);
                 EventFunc func = evt.Funcs[evt.FuncID];
                 func(evt.That, evt.Param);
             }
@@ -916,6 +926,8 @@ u32 NDS::RunFrame()
 {
     Current = this;
 
+    PROFILE_FRAME(Profiler);
+
     FrameStartTimestamp = SysTimestamp;
 
     GPU.TotalScanlines = 0;
@@ -974,6 +986,8 @@ u32 NDS::RunFrame()
 
                 if (CPUStop & CPUStop_GXStall)
                 {
+                    PROFILE_SECTION(Profiler, ProfSection_GXStall);
+
                     // GXFIFO stall
                     s32 cycles = GPU.GPU3D.CyclesToRunFor();
 
@@ -981,6 +995,8 @@ u32 NDS::RunFrame()
                 }
                 else if (CPUStop & CPUStop_DMA9)
                 {
+                    PROFILE_SECTION(Profiler, ProfSection_DMA9);
+
                     DMAs[0].Run();
                     if (!(CPUStop & CPUStop_GXStall)) DMAs[1].Run();
                     if (!(CPUStop & CPUStop_GXStall)) DMAs[2].Run();
@@ -993,11 +1009,18 @@ u32 NDS::RunFrame()
                 }
                 else
                 {
+                    PROFILE_SECTION(Profiler, ProfSection_ARM9);
                     ARM9.Execute<cpuMode>();
                 }
 
-                RunTimers(0);
-                GPU.GPU3D.Run();
+                {
+                    PROFILE_SECTION(Profiler, ProfSection_Timers);
+                    RunTimers(0);
+                }
+                {
+                    PROFILE_SECTION(Profiler, ProfSection_GPU3D);
+                    GPU.GPU3D.Run();
+                }
 
                 target = ARM9Timestamp >> ARM9ClockShift;
                 CurCPU = 1;
@@ -1008,6 +1031,8 @@ u32 NDS::RunFrame()
 
                     if (CPUStop & CPUStop_DMA7)
                     {
+                        PROFILE_SECTION(Profiler, ProfSection_DMA7);
+
                         DMAs[4].Run();
                         DMAs[5].Run();
                         DMAs[6].Run();
@@ -1020,13 +1045,18 @@ u32 NDS::RunFrame()
                     }
                     else
                     {
+                        PROFILE_SECTION(Profiler, ProfSection_ARM7);
                         ARM7.Execute<cpuMode>();
                     }
 
+                    PROFILE_SECTION(Profiler, ProfSection_Timers);
                     RunTimers(1);
                 }
 
-                RunSystem(target);
+                {
+                    PROFILE_SECTION(Profiler, ProfSection_Scheduler);
+                    RunSystem(target);
+                }
 
                 if (CPUStop & CPUStop_Sleep)
                 {
@@ -1048,6 +1078,9 @@ u32 NDS::RunFrame()
         break;
     }
 
+    // the SPU hands out its samples in blocks, make sure this frame's are all out
+    SPU.FlushOutput();
+
     // In the context of TASes, frame count is traditionally the primary measure of emulated time,
     // so it needs to be tracked even if NDS is powered off.
     NumFrames++;
@@ -1064,7 +1097,10 @@ u32 NDS::RunFrame()
 {
 #ifdef JIT_ENABLED
     if (EnableJIT)
+    {
+        JIT.BeginFrame();
         return RunFrame<CPUExecuteMode::JIT>();
+    }
     else
 #endif
 #ifdef GDBSTUB_ENABLED
@@ -3431,6 +3467,10 @@ void NDS::ARM9IOWrite16(u32 addr, u16 val)
 
     case 0x04000204:
         {
+#ifdef JIT_ENABLED
+            // the JIT decides on the slow memory functions based on the main RAM priority
+            JIT.WaitForCompileThread();
+#endif
             u16 oldVal = ExMemCnt[0];
             ExMemCnt[0] = val;
             ExMemCnt[1] = (ExMemCnt[1] & 0x007F) | (val & 0xFF80);
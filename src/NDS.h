@@ -38,6 +38,7 @@
 #include "ARMJIT.h"
 #include "MemRegion.h"
 #include "ARMJIT_Memory.h"
+#include "FrameProfiler.h"
 #include "ARM.h"
 #include "CRC32.h"
 #include "DMA.h"
@@ -320,6 +321,9 @@ public: // TODO: Encapsulate the rest of these members
     GBACart::GBACartSlot GBACartSlot;
     melonDS::GPU GPU;
     melonDS::AREngine AREngine;
+#ifdef FRAME_PROFILER_ENABLED
+    FrameProfiler Profiler;
+#endif
 
     const u32 ARM7WRAMSize = 0x10000;
     u8* ARM7WRAM;
@@ -0,0 +1,385 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <assert.h>
+#include <algorithm>
+#include <string.h>
+
+#include "RewindBuffer.h"
+#include "NDS.h"
+#include "Savestate.h"
+
+namespace melonDS
+{
+using Platform::Log;
+using Platform::LogLevel;
+
+/*
+    Delta format
+
+    00 - length of the older state
+    04 - ranges, one per section of the older state (the 16-byte global
+         header counts as a range too):
+         00 - offset in the older state
+         04 - length
+         08 - offset of the same section in the newer state, or NoBase if
+              the newer state has no section with that magic and length
+         0C - run-length coded data
+
+    Coded data is a sequence of (zero words, literal words) varint pairs, each
+    followed by the literal words. With a base, the words are older ^ newer;
+    without one they are the older words as-is. Lengths that aren't a multiple
+    of 4 end with the remaining bytes, XORed the same way.
+*/
+
+static constexpr u32 NoBase = 0xFFFFFFFF;
+
+struct StateRange
+{
+    u32 Magic;
+    u32 Offset;
+    u32 Length;
+};
+
+static void ListSections(const u8* buf, u32 len, std::vector<StateRange>& out)
+{
+    out.clear();
+
+    u32 offset = std::min<u32>(0x10, len);
+    out.push_back({0, 0, offset});
+
+    while (offset + 0x10 <= len)
+    {
+        u32 magic, seclen;
+        memcpy(&magic, buf + offset, 4);
+        memcpy(&seclen, buf + offset + 4, 4);
+        if (seclen < 0x10 || seclen > len - offset)
+            break;
+
+        out.push_back({magic, offset, seclen});
+        offset += seclen;
+    }
+
+    if (offset < len)
+        out.push_back({NoBase, offset, len - offset});
+}
+
+static inline u32 LoadWord(const u8* ptr)
+{
+    u32 val;
+    memcpy(&val, ptr, 4);
+    return val;
+}
+
+static void Put32(std::vector<u8>& out, u32 val)
+{
+    size_t pos = out.size();
+    out.resize(pos + 4);
+    memcpy(&out[pos], &val, 4);
+}
+
+static u32 Get32(const u8*& in)
+{
+    u32 val = LoadWord(in);
+    in += 4;
+    return val;
+}
+
+static void PutVarint(std::vector<u8>& out, u32 val)
+{
+    while (val >= 0x80)
+    {
+        out.push_back((val & 0x7F) | 0x80);
+        val >>= 7;
+    }
+    out.push_back(val);
+}
+
+static u32 GetVarint(const u8*& in)
+{
+    u32 val = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        u8 b = *in++;
+        val |= (u32)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return val;
+    }
+}
+
+template <bool xorBase>
+static void EncodeRange(std::vector<u8>& out, const u8* src, const u8* base, u32 len)
+{
+    auto word = [=](u32 i) -> u32
+    {
+        u32 val = LoadWord(src + i*4);
+        if (xorBase) val ^= LoadWord(base + i*4);
+        return val;
+    };
+
+    u32 numwords = len >> 2;
+    u32 i = 0;
+    while (i < numwords)
+    {
+        u32 zerostart = i;
+        while (i < numwords && word(i) == 0) i++;
+        u32 litstart = i;
+        while (i < numwords && word(i) != 0) i++;
+
+        PutVarint(out, litstart - zerostart);
+        PutVarint(out, i - litstart);
+
+        size_t pos = out.size();
+        out.resize(pos + (i - litstart) * 4);
+        for (u32 j = litstart; j < i; j++, pos += 4)
+        {
+            u32 val = word(j);
+            memcpy(&out[pos], &val, 4);
+        }
+    }
+
+    for (u32 j = numwords * 4; j < len; j++)
+        out.push_back(src[j] ^ (xorBase ? base[j] : 0));
+}
+
+static const u8* DecodeRange(const u8* in, u8* dst, const u8* base, u32 len)
+{
+    u32 numwords = len >> 2;
+    u32 i = 0;
+    while (i < numwords)
+    {
+        u32 zeros = GetVarint(in);
+        u32 literals = GetVarint(in);
+        assert(i + zeros + literals <= numwords);
+
+        if (base) memcpy(dst + i*4, base + i*4, zeros * 4);
+        else      memset(dst + i*4, 0, zeros * 4);
+        i += zeros;
+
+        for (u32 j = 0; j < literals; j++, i++)
+        {
+            u32 val = Get32(in);
+            if (base) val ^= LoadWord(base + i*4);
+            memcpy(dst + i*4, &val, 4);
+        }
+    }
+
+    for (u32 j = numwords * 4; j < len; j++)
+        dst[j] = *in++ ^ (base ? base[j] : 0);
+
+    return in;
+}
+
+
+RewindBuffer::RewindBuffer(u32 interval, u64 budget) :
+    Interval(interval ? interval : 1),
+    Budget(budget)
+{
+    Pending = std::make_unique<Savestate>();
+
+    Sema_WorkStart = Platform::Semaphore_Create();
+    Sema_WorkDone = Platform::Semaphore_Create();
+    Worker = Platform::Thread_Create([this]() { WorkerFunc(); });
+}
+
+RewindBuffer::~RewindBuffer()
+{
+    WaitIdle();
+
+    Exiting = true;
+    Platform::Semaphore_Post(Sema_WorkStart);
+    Platform::Thread_Wait(Worker);
+    Platform::Thread_Free(Worker);
+
+    Platform::Semaphore_Free(Sema_WorkStart);
+    Platform::Semaphore_Free(Sema_WorkDone);
+}
+
+void RewindBuffer::SetInterval(u32 interval)
+{
+    Interval = interval ? interval : 1;
+}
+
+void RewindBuffer::SetBudget(u64 budget)
+{
+    WaitIdle();
+    Budget = budget;
+    Trim();
+}
+
+void RewindBuffer::Frame(NDS& nds)
+{
+    if (++FramesSinceSnapshot < Interval)
+        return;
+
+    if (Busy)
+    {
+        // the previous snapshot is still being encoded, try again next frame
+        if (!Platform::Semaphore_TryWait(Sema_WorkDone))
+            return;
+        Busy = false;
+    }
+
+    FramesSinceSnapshot = 0;
+
+    Pending->Rewind(true);
+    if (!nds.DoSavestate(Pending.get()) || Pending->Error)
+    {
+        Log(LogLevel::Error, "rewind: failed to take a snapshot\n");
+        return;
+    }
+
+    Busy = true;
+    Platform::Semaphore_Post(Sema_WorkStart);
+}
+
+bool RewindBuffer::Rewind(NDS& nds)
+{
+    WaitIdle();
+    FramesSinceSnapshot = 0;
+
+    if (Current.empty())
+        return false;
+
+    Savestate state(Current.data(), Current.size(), false);
+    bool ok = !state.Error && nds.DoSavestate(&state) && !state.Error;
+    if (!ok)
+        Log(LogLevel::Error, "rewind: failed to load snapshot\n");
+
+    // step back: rebuild the previous snapshot from this one and its delta
+    if (Deltas.empty())
+    {
+        Current.clear();
+    }
+    else
+    {
+        const std::vector<u8>& delta = Deltas.back();
+        const u8* in = delta.data();
+        const u8* end = in + delta.size();
+
+        Scratch.resize(Get32(in));
+        while (in < end)
+        {
+            u32 offset = Get32(in);
+            u32 len = Get32(in);
+            u32 baseoffset = Get32(in);
+            in = DecodeRange(in, Scratch.data() + offset,
+                             baseoffset == NoBase ? nullptr : Current.data() + baseoffset, len);
+        }
+
+        Current.swap(Scratch);
+        DeltaBytes -= delta.size();
+        Deltas.pop_back();
+    }
+
+    Trim();
+    return ok;
+}
+
+void RewindBuffer::Clear()
+{
+    WaitIdle();
+
+    Current.clear();
+    Deltas.clear();
+    DeltaBytes = 0;
+    FramesSinceSnapshot = 0;
+    Trim();
+}
+
+void RewindBuffer::WaitIdle()
+{
+    if (!Busy) return;
+
+    Platform::Semaphore_Wait(Sema_WorkDone);
+    Busy = false;
+}
+
+void RewindBuffer::WorkerFunc()
+{
+    for (;;)
+    {
+        Platform::Semaphore_Wait(Sema_WorkStart);
+        if (Exiting) break;
+
+        Commit();
+        Platform::Semaphore_Post(Sema_WorkDone);
+    }
+}
+
+void RewindBuffer::Commit()
+{
+    const u8* newer = static_cast<const u8*>(Pending->Buffer());
+    u32 newerlen = Pending->Length();
+
+    if (!Current.empty())
+    {
+        // the delta turns the new snapshot back into the one it replaces
+        std::vector<StateRange> older, newersecs;
+        ListSections(Current.data(), Current.size(), older);
+        ListSections(newer, newerlen, newersecs);
+
+        std::vector<u8> delta;
+        Put32(delta, Current.size());
+
+        for (size_t i = 0; i < older.size(); i++)
+        {
+            const StateRange& range = older[i];
+
+            // layouts almost never change between snapshots, check the same index first
+            const StateRange* base = nullptr;
+            if (i < newersecs.size() && newersecs[i].Magic == range.Magic)
+                base = &newersecs[i];
+            else
+            {
+                for (const StateRange& sec : newersecs)
+                    if (sec.Magic == range.Magic) { base = &sec; break; }
+            }
+            if (base && base->Length != range.Length)
+                base = nullptr;
+
+            Put32(delta, range.Offset);
+            Put32(delta, range.Length);
+            Put32(delta, base ? base->Offset : NoBase);
+            if (base)
+                EncodeRange<true>(delta, Current.data() + range.Offset, newer + base->Offset, range.Length);
+            else
+                EncodeRange<false>(delta, Current.data() + range.Offset, nullptr, range.Length);
+        }
+
+        delta.shrink_to_fit();
+        DeltaBytes += delta.size();
+        Deltas.push_back(std::move(delta));
+    }
+
+    Current.assign(newer, newer + newerlen);
+    Trim();
+}
+
+void RewindBuffer::Trim()
+{
+    while (!Deltas.empty() && Current.size() + DeltaBytes > Budget)
+    {
+        DeltaBytes -= Deltas.front().size();
+        Deltas.pop_front();
+    }
+
+    NumStates = Current.empty() ? 0 : (u32)(Deltas.size() + 1);
+    UsedBytes = Current.size() + DeltaBytes;
+}
+
+}
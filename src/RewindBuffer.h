@@ -0,0 +1,101 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef REWINDBUFFER_H
+#define REWINDBUFFER_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+class NDS;
+class Savestate;
+
+// Bounded history of savestates for rewinding.
+//
+// The newest snapshot is kept whole. Every older one is stored as the XOR of
+// itself against the snapshot that followed it, run-length coded per savestate
+// section (consecutive frames differ in a few KB of RAM, so the XOR is mostly
+// zeroes). Stepping back applies the newest delta to the whole snapshot, and
+// the oldest delta can be dropped at any time to stay within the budget.
+//
+// Only the savestate capture runs on the emulation thread; encoding the delta
+// happens on a worker thread.
+class RewindBuffer
+{
+public:
+    // interval: take a snapshot every this many frames
+    // budget: upper bound on the memory held by snapshots, in bytes
+    RewindBuffer(u32 interval, u64 budget);
+    ~RewindBuffer();
+    RewindBuffer(const RewindBuffer&) = delete;
+    RewindBuffer& operator=(const RewindBuffer&) = delete;
+
+    void SetInterval(u32 interval);
+    void SetBudget(u64 budget);
+
+    // call once per emulated frame
+    void Frame(NDS& nds);
+
+    // loads the most recent snapshot and drops it from the history
+    // returns false if there was nothing to rewind to
+    bool Rewind(NDS& nds);
+
+    void Clear();
+
+    [[nodiscard]] u32 NumSnapshots() const { return NumStates; }
+    [[nodiscard]] u64 MemoryUsed() const { return UsedBytes; }
+
+private:
+    void WorkerFunc();
+    void WaitIdle();
+    void Commit();
+    void Trim();
+
+    u32 Interval;
+    u64 Budget;
+    u32 FramesSinceSnapshot = 0;
+
+    // snapshot taken on the emulation thread, waiting to be committed
+    std::unique_ptr<Savestate> Pending;
+
+    // owned by the worker while it is busy
+    std::vector<u8> Current;
+    std::deque<std::vector<u8>> Deltas; // oldest first
+    u64 DeltaBytes = 0;
+    std::vector<u8> Scratch;
+
+    std::atomic<u32> NumStates {0};
+    std::atomic<u64> UsedBytes {0};
+
+    Platform::Thread* Worker = nullptr;
+    Platform::Semaphore* Sema_WorkStart = nullptr;
+    Platform::Semaphore* Sema_WorkDone = nullptr;
+    bool Busy = false;
+    bool Exiting = false;
+};
+
+}
+
+#endif // REWINDBUFFER_H
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <cmath>
+#include <algorithm>
 #include "Platform.h"
 #include "NDS.h"
 #include "DSi.h"
@@ -199,25 +200,16 @@ SPU::SPU(melonDS::NDS& nds, AudioBitDepth bitdepth, AudioInterpolation interpola
         SPUCaptureUnit(0, nds),
         SPUCaptureUnit(1, nds),
     },
-    AudioLock(Platform::Mutex_Create()),
     Degrade10Bit(bitdepth == AudioBitDepth::_10Bit || (nds.ConsoleType == 1 && bitdepth == AudioBitDepth::Auto))
 {
     NDS.RegisterEventFuncs(Event_SPU, this, {MakeEventThunk(SPU, Mix)});
 
     ApplyBias = true;
     Degrade10Bit = false;
-
-    memset(OutputBuffer, 0, 2*OutputBufferSize*2);
-
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
 }
 
 SPU::~SPU()
 {
-    Platform::Mutex_Free(AudioLock);
-    AudioLock = nullptr;
-
     NDS.UnregisterEventFuncs(Event_SPU);
 }
 
@@ -240,12 +232,8 @@ void SPU::Reset()
 
 void SPU::Stop()
 {
-    Platform::Mutex_Lock(AudioLock);
-    memset(OutputBuffer, 0, 2*OutputBufferSize*2);
-
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
-    Platform::Mutex_Unlock(AudioLock);
+    SkipOutput(0);
+    MixBufferPos = 0;
 }
 
 void SPU::DoSavestate(Savestate* file)
@@ -829,6 +817,7 @@ void SPU::Mix(u32 dummy)
         for (int i = 4; i < 16; i++)
         {
             SPUChannel* chan = &Channels[i];
+            if (!(chan->Cnt & (1<<31))) continue;
 
             s32 channel = chan->DoRun();
             chan->PanOutput(channel, left, right);
@@ -940,73 +929,84 @@ void SPU::Mix(u32 dummy)
         rightoutput &= 0xFFFFFFC0;
     }
 
-    Platform::Mutex_Lock(AudioLock);
-    OutputBuffer[OutputBufferWritePos++] = leftoutput >> 1;
-    OutputBuffer[OutputBufferWritePos++] = rightoutput >> 1;
+    MixBuffer[MixBufferPos++] = leftoutput >> 1;
+    MixBuffer[MixBufferPos++] = rightoutput >> 1;
+    if (MixBufferPos == 2*MixBufferLen)
+        FlushOutput();
 
-    OutputBufferWritePos &= ((2*OutputBufferSize)-1);
+    NDS.ScheduleEvent(Event_SPU, true, 1024, 0, 0);
+}
 
-    if (OutputBufferWritePos == OutputBufferReadPos)
+void SPU::FlushOutput()
+{
+    if (!MixBufferPos) return;
+
+    // the read position can't be pushed from here, so when the reader falls
+    // behind, what doesn't fit is dropped
+    u32 samples = MixBufferPos / 2;
+    u32 writepos = OutputWritePos.load(std::memory_order_relaxed);
+    u32 readpos = OutputReadPos.load(std::memory_order_acquire);
+    u32 space = OutputBufferSize - (writepos - readpos);
+    if (samples > space)
     {
-        // advance the read position too, to avoid losing the entire FIFO
-        OutputBufferReadPos += 2;
-        OutputBufferReadPos &= ((2*OutputBufferSize)-1);
+        OutputOverruns.fetch_add(samples - space, std::memory_order_relaxed);
+        samples = space;
     }
-    Platform::Mutex_Unlock(AudioLock);
 
-    NDS.ScheduleEvent(Event_SPU, true, 1024, 0, 0);
+    u32 pos = writepos & (OutputBufferSize-1);
+    u32 len1 = std::min(samples, OutputBufferSize - pos);
+    memcpy(&OutputBuffer[pos*2], &MixBuffer[0], len1*2*sizeof(s16));
+    memcpy(&OutputBuffer[0], &MixBuffer[len1*2], (samples-len1)*2*sizeof(s16));
+
+    OutputWritePos.store(writepos + samples, std::memory_order_release);
+    MixBufferPos = 0;
 }
 
-void SPU::TrimOutput()
+void SPU::SkipOutput(u32 keep)
 {
-    Platform::Mutex_Lock(AudioLock);
-    const int halflimit = (OutputBufferSize / 2);
+    u32 writepos = OutputWritePos.load(std::memory_order_relaxed);
+    u32 size = GetOutputSize();
+    if (keep > size) keep = size;
 
-    int readpos = OutputBufferWritePos - (halflimit*2);
-    if (readpos < 0) readpos += (OutputBufferSize*2);
+    OutputSkipPos.store(writepos - keep, std::memory_order_release);
+    OutputSkip.store(true, std::memory_order_release);
+}
 
-    OutputBufferReadPos = readpos;
-    Platform::Mutex_Unlock(AudioLock);
+void SPU::TrimOutput()
+{
+    SkipOutput(OutputBufferSize / 2);
 }
 
 void SPU::DrainOutput()
 {
-    Platform::Mutex_Lock(AudioLock);
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
-    Platform::Mutex_Unlock(AudioLock);
+    SkipOutput(0);
+    MixBufferPos = 0;
 }
 
 void SPU::InitOutput()
 {
-    Platform::Mutex_Lock(AudioLock);
-    memset(OutputBuffer, 0, 2*OutputBufferSize*2);
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
-    Platform::Mutex_Unlock(AudioLock);
+    SkipOutput(0);
+    OutputOverruns.store(0, std::memory_order_relaxed);
+    OutputUnderruns.store(0, std::memory_order_relaxed);
+    MixBufferPos = 0;
 }
 
 int SPU::GetOutputSize() const
 {
-    Platform::Mutex_Lock(AudioLock);
-
-    int ret;
-    if (OutputBufferWritePos >= OutputBufferReadPos)
-        ret = OutputBufferWritePos - OutputBufferReadPos;
-    else
-        ret = (OutputBufferSize*2) - OutputBufferReadPos + OutputBufferWritePos;
-
-    ret >>= 1;
+    u32 readpos = OutputReadPos.load(std::memory_order_acquire);
+    if (OutputSkip.load(std::memory_order_acquire))
+    {
+        u32 skippos = OutputSkipPos.load(std::memory_order_acquire);
+        if ((s32)(skippos - readpos) > 0) readpos = skippos;
+    }
 
-    Platform::Mutex_Unlock(AudioLock);
-    return ret;
+    u32 writepos = OutputWritePos.load(std::memory_order_acquire);
+    return writepos - readpos;
 }
 
 void SPU::Sync(bool wait)
 {
     // this function is currently not used anywhere
-    // depending on the usage context the thread safety measures could be made
-    // a lot faster
 
     // sync to audio output in case the core is running too fast
     // * wait=true: wait until enough audio data has been played
@@ -1016,46 +1016,38 @@ void SPU::Sync(bool wait)
 
     if (wait)
     {
-        // TODO: less CPU-intensive wait?
-        while (GetOutputSize() > halflimit);
+        while (GetOutputSize() > halflimit)
+            Platform::Sleep(1000);
     }
     else if (GetOutputSize() > halflimit)
     {
-        Platform::Mutex_Lock(AudioLock);
-
-        int readpos = OutputBufferWritePos - (halflimit*2);
-        if (readpos < 0) readpos += (OutputBufferSize*2);
-
-        OutputBufferReadPos = readpos;
-
-        Platform::Mutex_Unlock(AudioLock);
+        TrimOutput();
     }
 }
 
 int SPU::ReadOutput(s16* data, int samples)
 {
-    Platform::Mutex_Lock(AudioLock);
-    if (OutputBufferReadPos == OutputBufferWritePos)
+    if (samples < 1) return 0;
+
+    u32 readpos = OutputReadPos.load(std::memory_order_relaxed);
+    if (OutputSkip.load(std::memory_order_relaxed) && OutputSkip.exchange(false, std::memory_order_acquire))
     {
-        Platform::Mutex_Unlock(AudioLock);
-        return 0;
+        u32 skippos = OutputSkipPos.load(std::memory_order_acquire);
+        if ((s32)(skippos - readpos) > 0) readpos = skippos;
     }
 
-    for (int i = 0; i < samples; i++)
-    {
-        *data++ = OutputBuffer[OutputBufferReadPos++];
-        *data++ = OutputBuffer[OutputBufferReadPos++];
-        OutputBufferReadPos &= ((2*OutputBufferSize)-1);
+    u32 writepos = OutputWritePos.load(std::memory_order_acquire);
+    u32 num = std::min(writepos - readpos, (u32)samples);
+    if (num < (u32)samples)
+        OutputUnderruns.fetch_add(samples - num, std::memory_order_relaxed);
 
-        if (OutputBufferWritePos == OutputBufferReadPos)
-        {
-            Platform::Mutex_Unlock(AudioLock);
-            return i+1;
-        }
-    }
+    u32 pos = readpos & (OutputBufferSize-1);
+    u32 len1 = std::min(num, OutputBufferSize - pos);
+    memcpy(&data[0], &OutputBuffer[pos*2], len1*2*sizeof(s16));
+    memcpy(&data[len1*2], &OutputBuffer[0], (num-len1)*2*sizeof(s16));
 
-    Platform::Mutex_Unlock(AudioLock);
-    return samples;
+    OutputReadPos.store(readpos + num, std::memory_order_release);
+    return num;
 }
 
 
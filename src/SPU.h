@@ -19,6 +19,8 @@
 #ifndef SPU_H
 #define SPU_H
 
+#include <atomic>
+
 #include "Savestate.h"
 #include "Platform.h"
 
@@ -129,6 +131,8 @@ public:
 
     s32 DoRun()
     {
+        if (!(Cnt & (1<<31))) return 0;
+
         switch ((Cnt >> 29) & 0x3)
         {
         case 0: return Run<0>(); break;
@@ -234,7 +238,17 @@ public:
     void SetApplyBias(bool enable);
 
     void Mix(u32 dummy);
+    // moves the mixed samples to the output buffer, done at the end of every frame
+    void FlushOutput();
+
+    // capacity of the output buffer, in stereo frames
+    static constexpr u32 OutputBufferSize = 4*1024;
 
+    // the output buffer is a single-producer single-consumer ring: the emulator
+    // thread mixes into it, one other thread (the audio callback) reads from it,
+    // and neither side ever waits for the other
+    // ReadOutput() and GetOutputSize() may be called from the reading thread,
+    // everything else from the emulator thread
     void TrimOutput();
     void DrainOutput();
     void InitOutput();
@@ -242,6 +256,11 @@ public:
     void Sync(bool wait);
     int ReadOutput(s16* data, int samples);
 
+    // frames dropped because the buffer was full, and frames reads asked for
+    // but didn't get, since the last InitOutput()
+    u64 GetOutputOverruns() const { return OutputOverruns.load(std::memory_order_relaxed); }
+    u64 GetOutputUnderruns() const { return OutputUnderruns.load(std::memory_order_relaxed); }
+
     u8 Read8(u32 addr);
     u16 Read16(u32 addr);
     u32 Read32(u32 addr);
@@ -250,13 +269,30 @@ public:
     void Write32(u32 addr, u32 val);
 
 private:
-    static const u32 OutputBufferSize = 2*1024;  // TODO: configurable audio buffer sizes?
+    // discards everything written so far, except the last 'keep' frames
+    void SkipOutput(u32 keep);
+
     melonDS::NDS& NDS;
-    s16 OutputBuffer[2 * OutputBufferSize] {};
-    u32 OutputBufferWritePos = 0;
-    u32 OutputBufferReadPos = 0;
 
-    Platform::Mutex* AudioLock;
+    // positions are free-running frame counts, the buffer index is their low bits
+    // each one is only written by one side, and gets its own cache line
+    alignas(64) std::atomic<u32> OutputWritePos {0};
+    std::atomic<u64> OutputOverruns {0};
+    alignas(64) std::atomic<u32> OutputReadPos {0};
+    std::atomic<u64> OutputUnderruns {0};
+
+    // the emulator thread can't move the read position itself
+    // it asks the reader to skip ahead to OutputSkipPos instead
+    alignas(64) std::atomic<u32> OutputSkipPos {0};
+    std::atomic<bool> OutputSkip {false};
+
+    alignas(64) s16 OutputBuffer[2 * OutputBufferSize] {};
+
+    // samples are mixed here first, and moved to the output buffer a block at a time
+    // so that the write position is only published once per block
+    static const u32 MixBufferLen = 64;
+    s16 MixBuffer[2 * MixBufferLen] {};
+    u32 MixBufferPos = 0;
 
     u16 Cnt = 0;
     u8 MasterVolume = 0;
@@ -37,7 +37,7 @@ static const char* SAVESTATE_MAGIC = "MELN";
     04 - version major
     06 - version minor
     08 - length
-    0C - reserved (should be game serial later!)
+    0C - offset of the section table (minor 2+), 0 if there is none
 
     section header:
     00 - section magic
@@ -45,6 +45,11 @@ static const char* SAVESTATE_MAGIC = "MELN";
     08 - reserved
     0C - reserved
 
+    section table (minor 2+):
+    a section with magic "TOC.", written last, holding one 8-byte entry
+    per section: its magic, then the offset of its header in the file.
+    Loading looks sections up in it instead of walking every header.
+
     Implementation details
 
     version difference:
@@ -110,8 +115,15 @@ Savestate::Savestate(void *buffer, u32 size, bool save) :
             return;
         }
 
-        // The next 4 bytes are reserved
-        buffer_offset += 4;
+        if (minor >= 2)
+        {
+            ReadSectionTable();
+        }
+        else
+        {
+            // The next 4 bytes are reserved
+            buffer_offset += 4;
+        }
     }
 }
 
@@ -164,6 +176,10 @@ void Savestate::Section(const char* magic)
 
         CurSection = buffer_offset;
 
+        u32 magic32;
+        memcpy(&magic32, magic, sizeof(magic32));
+        section_table.push_back({magic32, CurSection});
+
         // Write the new section's magic number
         VarArray((void*)magic, 4);
 
@@ -253,8 +269,12 @@ void Savestate::VarArray(void* data, u32 len)
 void Savestate::Finish()
 {
     if (Error || finished) return;
-    CloseCurrentSection();
-    WriteStateLength();
+    if (Saving)
+    {
+        CloseCurrentSection();
+        WriteSectionTable();
+        WriteStateLength();
+    }
     finished = true;
 }
 
@@ -266,6 +286,13 @@ void Savestate::Rewind(bool save)
 
     buffer_offset = 0;
     finished = false;
+
+    if (Saving)
+    {
+        // start over with a fresh header, so the buffer can be reused
+        section_table.clear();
+        WriteSavestateHeader();
+    }
 }
 
 void Savestate::CloseCurrentSection()
@@ -327,10 +354,70 @@ void Savestate::WriteSavestateHeader()
     u32 zero = 0;
     Var32(&zero);
 
-    // The following 4 bytes are reserved
+    // The following 4 bytes are the section table's offset, also filled in at the end
     Var32(&zero);
 }
 
+void Savestate::WriteSectionTable()
+{
+    u32 table_offset = buffer_offset;
+    u32 zero = 0;
+
+    VarArray((void*)"TOC.", 4);
+    u32 table_length = 16 + (u32)section_table.size() * 8;
+    Var32(&table_length);
+    Var32(&zero);
+    Var32(&zero);
+
+    for (SectionEntry& entry : section_table)
+    {
+        Var32(&entry.Magic);
+        Var32(&entry.Offset);
+    }
+
+    if (Error) return;
+    memcpy(buffer + 0x0C, &table_offset, sizeof(table_offset));
+}
+
+void Savestate::ReadSectionTable()
+{
+    u32 table_offset = 0;
+    Var32(&table_offset);
+    if (Error) return;
+
+    // a missing or damaged table isn't fatal, FindSection can still walk the headers
+    if (table_offset < 0x10 || table_offset > buffer_length - 16 ||
+        memcmp(buffer + table_offset, "TOC.", 4) != 0)
+    {
+        Log(LogLevel::Warn, "savestate: section table not found\n");
+        return;
+    }
+
+    u32 table_length = 0;
+    memcpy(&table_length, buffer + table_offset + 4, sizeof(table_length));
+    if (table_length < 16 || table_length > buffer_length - table_offset || (table_length & 7))
+    {
+        Log(LogLevel::Warn, "savestate: bad section table length %u\n", table_length);
+        return;
+    }
+
+    u32 num_entries = (table_length - 16) / 8;
+    section_table.resize(num_entries);
+    for (u32 i = 0; i < num_entries; i++)
+    {
+        const u8* entry = buffer + table_offset + 16 + i * 8;
+        memcpy(&section_table[i].Magic, entry, 4);
+        memcpy(&section_table[i].Offset, entry + 4, 4);
+
+        if (section_table[i].Offset > buffer_length - 16)
+        {
+            Log(LogLevel::Warn, "savestate: section table entry %u out of bounds\n", i);
+            section_table.clear();
+            return;
+        }
+    }
+}
+
 void Savestate::WriteStateLength()
 {
     // Not to be confused with the buffer length.
@@ -346,6 +433,21 @@ u32 Savestate::FindSection(const char* magic) const
 {
     if (!magic) return NO_SECTION;
 
+    if (!section_table.empty())
+    {
+        u32 magic32;
+        memcpy(&magic32, magic, sizeof(magic32));
+
+        for (const SectionEntry& entry : section_table)
+        {
+            if (entry.Magic == magic32)
+                return entry.Offset + 16;
+        }
+
+        Log(LogLevel::Error, "savestate: section %s not found. blarg\n", magic);
+        return NO_SECTION;
+    }
+
     // Start looking at the savestate's beginning, right after its global header
     // (we can't start from the current offset because then we'd lose the ability to rearrange sections)
 
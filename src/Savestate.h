@@ -21,11 +21,12 @@
 
 #include <cstring>
 #include <string>
+#include <vector>
 #include <stdio.h>
 #include "types.h"
 
 #define SAVESTATE_MAJOR 12
-#define SAVESTATE_MINOR 1
+#define SAVESTATE_MINOR 2
 
 namespace melonDS
 {
@@ -72,7 +73,7 @@ public:
 
     void Finish();
 
-    // TODO rewinds the stream
+    // rewinds the stream, to load the state again or save a new one over it
     void Rewind(bool save);
 
     bool IsAtLeastVersion(u32 major, u32 minor)
@@ -108,6 +109,15 @@ public:
 
 private:
     static constexpr u32 NO_SECTION = 0xffffffff;
+
+    struct SectionEntry
+    {
+        u32 Magic;
+        u32 Offset;
+    };
+
+    void ReadSectionTable();
+    void WriteSectionTable();
     void CloseCurrentSection();
     bool Resize(u32 new_length);
     void WriteSavestateHeader();
@@ -118,6 +128,7 @@ private:
     u32 buffer_length;
     bool buffer_owned;
     bool finished;
+    std::vector<SectionEntry> section_table;
 };
 }
 
@@ -1,4 +1,7 @@
 #include "TexReplace.h"
+#include "GPU.h"
+#include "GPU3D_Texcache.h"
+#include "Platform.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -10,8 +13,15 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <cstring>
 #include <cstdint>
 #include <filesystem>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <unordered_set>
+#include <algorithm>
+#include <chrono>
 
 namespace melonDS {
 
@@ -20,24 +30,149 @@ bool TexReplace_ReplaceEnabled()  { return gEnableTexReplace.load(std::memory_or
 bool TexReplace_DumpEnabled()     { return gEnable3DTexDump.load(std::memory_order_relaxed); }
 void TexReplace_SetReplace(bool v){ gEnableTexReplace.store(v, std::memory_order_relaxed); }
 void TexReplace_SetDump(bool v)   { gEnable3DTexDump.store(v, std::memory_order_relaxed); }
+bool TexReplace_DumpPackEnabled() { return gEnableTexDumpPack.load(std::memory_order_relaxed); }
+void TexReplace_SetDumpPack(bool v){ gEnableTexDumpPack.store(v, std::memory_order_relaxed); }
+bool TexReplace_MigrateEnabled()  { return gEnableTexMigrate.load(std::memory_order_relaxed); }
+void TexReplace_SetMigrate(bool v){ gEnableTexMigrate.store(v, std::memory_order_relaxed); }
+bool TexReplace_PrewarmEnabled()  { return gEnableTexPrewarm.load(std::memory_order_relaxed); }
+void TexReplace_SetPrewarm(bool v){ gEnableTexPrewarm.store(v, std::memory_order_relaxed); }
 
 static std::mutex                gReplMx;
 static std::unordered_map<uint64_t, std::shared_ptr<ReplacementTex>> gByHash; // key: h64^fmt^w^h (как у тебя sig)
-static std::unordered_map<uint64_t, std::weak_ptr<ReplacementTex>>   gBind;   // key: vramaddr^texparam^texpal
+static std::unordered_set<uint64_t> gPending;   // sig'и, которые сейчас декодирует пул
+static std::atomic<uint32_t>        gGeneration{1}; // растёт на каждом ClearAllReplacements
+
+// LRU-бюджет. "Время" — счётчик кадров, который двигает TexReplaceCache::Invalidate.
+static std::atomic<uint32_t>        gUseClock{1};
+static std::atomic<size_t>          gBudget{size_t(1024) << 20};
+static uint64_t                     gResidentBytes = 0;  // под gReplMx
+static uint64_t                     gEvictedCount = 0;   // под gReplMx
+static std::atomic<uint32_t>        gEvictSerial{0};     // растёт при каждом выселении, без лока
+static constexpr uint32_t           kEvictMinAge = 2;    // кадров: моложе — не выселяем, иначе будет перезагрузка по кругу
+
+struct IndexEntry {
+    uint64_t h64;
+    uint32_t fmt;
+    uint16_t w, h;
+};
+
+// Индекс text_replace/mod/: какие замены вообще существуют. Всё, чего нет в
+// индексе, — гарантированный промах без обращения к ФС.
+static std::unordered_map<uint64_t, IndexEntry> gIndex; // sig -> доступный PNG
+static std::unordered_set<uint64_t> gMissing;   // в индексе есть, но PNG не декодируется
+static bool                         gIndexReady = false;
+static bool                         gIndexQueued = false;   // задача пересканирования в очереди или уже на воркере
+static bool                         gPrewarmWanted = false; // декодировать всё из индекса после пересканирования
+static int64_t                      gIndexStamp = 0;
+static std::chrono::steady_clock::time_point gIndexCheckedAt;
 
 static inline uint64_t MakeSig(uint64_t h64, uint32_t fmt, uint16_t w, uint16_t h) {
     return h64 ^ (uint64_t(fmt) << 56) ^ (uint64_t(w) << 32) ^ (uint64_t(h) << 16);
 }
-static inline uint64_t MakeBindKey(uint32_t vramaddr, uint32_t texparam, uint32_t texpal) {
-    // простой стабильный ключ бинда для быстрого доступа на пикселях
-    uint64_t k = vramaddr;
-    k = (k << 32) ^ (texparam * 1469598103u) ^ (texpal * 16777619u);
-    return k;
+static uint64_t MipBytes(const std::vector<ReplMipLevel>& mips)
+{
+    uint64_t bytes = 0;
+    for (const auto& L : mips) bytes += L.texels.capacity() * sizeof(uint32_t);
+    return bytes;
+}
+// под gReplMx: mips достраиваются позже и учитываются в момент подмены
+static uint64_t ResidentBytes(const ReplacementTex& R)
+{
+    return R.rgba.capacity() + MipBytes(R.mips);
 }
 
-void ClearBindings() {
-    std::lock_guard<std::mutex> lk(gReplMx);
-    gBind.clear();
+// под gReplMx; keep — только что вставленная текстура, её не выселяем
+static void EnforceBudget(uint64_t keep)
+{
+    const uint64_t budget = gBudget.load(std::memory_order_relaxed);
+    if (gResidentBytes <= budget) return;
+
+    const uint32_t now = gUseClock.load(std::memory_order_relaxed);
+    std::vector<std::pair<uint32_t, uint64_t>> victims; // (lastUse, sig)
+    for (const auto& [sig, R] : gByHash) {
+        uint32_t used = R->lastUse.load(std::memory_order_relaxed);
+        if (sig != keep && now - used >= kEvictMinAge) victims.emplace_back(used, sig);
+    }
+    std::sort(victims.begin(), victims.end());
+
+    uint32_t n = 0;
+    for (const auto& [used, sig] : victims) {
+        if (gResidentBytes <= budget) break;
+        auto it = gByHash.find(sig);
+        gResidentBytes -= ResidentBytes(*it->second);
+        it->second->evicted.store(true, std::memory_order_release);
+        gByHash.erase(it);
+        n++;
+    }
+    gEvictedCount += n;
+    if (n) gEvictSerial.fetch_add(1, std::memory_order_release);
+
+    if (n)
+        Platform::Log(Platform::LogLevel::Info,
+                      "TexReplace: evicted %u textures, %zu resident (%llu KB of %llu KB), %llu evicted total\n",
+                      n, gByHash.size(), (unsigned long long)(gResidentBytes >> 10),
+                      (unsigned long long)(budget >> 10), (unsigned long long)gEvictedCount);
+}
+
+static inline uint32_t PackRGB6A5(const uint8_t* px)
+{
+    // 8bit -> 6bit/5bit как в пайплайне рендера
+    uint32_t r = (px[0] * 63 + 127) / 255;
+    uint32_t g = (px[1] * 63 + 127) / 255;
+    uint32_t b = (px[2] * 63 + 127) / 255;
+    uint32_t a = (px[3] * 31 + 127) / 255;
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+// 2x2 box-фильтр (для нечётных размеров крайний ряд дублируется)
+static void Downsample(const std::vector<uint8_t>& src, int w, int h,
+                       std::vector<uint8_t>& dst, int& dw, int& dh)
+{
+    dw = std::max(1, w / 2);
+    dh = std::max(1, h / 2);
+    dst.resize((size_t)dw * dh * 4);
+    for (int y = 0; y < dh; y++) {
+        const uint8_t* r0 = &src[(size_t)std::min(y*2,   h-1) * w * 4];
+        const uint8_t* r1 = &src[(size_t)std::min(y*2+1, h-1) * w * 4];
+        for (int x = 0; x < dw; x++) {
+            int x0 = std::min(x*2, w-1) * 4, x1 = std::min(x*2+1, w-1) * 4;
+            for (int c = 0; c < 4; c++)
+                dst[((size_t)y * dw + x) * 4 + c] = (uint8_t)((r0[x0+c] + r0[x1+c] + r1[x0+c] + r1[x1+c] + 2) >> 2);
+        }
+    }
+}
+
+static void BuildSoftMips(const ReplacementTex& R, int ow, int oh, std::vector<ReplMipLevel>& mips)
+{
+    // пропускаем уровни крупнее DS-текстуры
+    std::vector<uint8_t> cur = R.rgba, next;
+    int w = R.w, h = R.h;
+    while (w / 2 >= ow && h / 2 >= oh) {
+        int nw, nh;
+        Downsample(cur, w, h, next, nw, nh);
+        cur.swap(next);
+        w = nw; h = nh;
+    }
+
+    for (;;) {
+        ReplMipLevel L;
+        L.w = w; L.h = h;
+        L.tilesW = (w + 3) / 4;
+        L.sx = (float)w / (float)ow;
+        L.sy = (float)h / (float)oh;
+        L.texels.assign((size_t)L.tilesW * ((h + 3) / 4) * 16, 0);
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                L.texels[((((y >> 2) * L.tilesW) + (x >> 2)) << 4) | ((y & 3) << 2) | (x & 3)] =
+                    PackRGB6A5(&cur[((size_t)y * w + x) * 4]);
+        mips.push_back(std::move(L));
+
+        if (w == 1 && h == 1) break;
+        int nw, nh;
+        Downsample(cur, w, h, next, nw, nh);
+        cur.swap(next);
+        w = nw; h = nh;
+    }
 }
 
 static std::shared_ptr<ReplacementTex> LoadPNGFor(uint64_t h64, uint32_t fmt, int ow, int oh)
@@ -52,6 +187,7 @@ static std::shared_ptr<ReplacementTex> LoadPNGFor(uint64_t h64, uint32_t fmt, in
 
     auto R = std::make_shared<ReplacementTex>();
     R->w = W; R->h = H;
+    R->ow = ow; R->oh = oh;
     R->sx = (float)W / (float)ow;
     R->sy = (float)H / (float)oh;
     R->rgba.assign(data, data + (W*H*4));
@@ -59,6 +195,326 @@ static std::shared_ptr<ReplacementTex> LoadPNGFor(uint64_t h64, uint32_t fmt, in
     return R;
 }
 
+const ReplMipLevel* ReplacementTex::PickMip(float minify) const
+{
+    std::call_once(mipsBuilt, [this]{
+        std::vector<ReplMipLevel> built;
+        BuildSoftMips(*this, ow, oh, built);
+
+        std::lock_guard<std::mutex> lk(gReplMx);
+        mips.swap(built);
+        // выселенная уже списана из gResidentBytes целиком
+        if (!evicted.load(std::memory_order_relaxed)) {
+            gResidentBytes += MipBytes(mips);
+            EnforceBudget(0);
+        }
+    });
+
+    if (mips.empty()) return nullptr;
+    size_t level = 0;
+    while (minify >= 2.0f && level + 1 < mips.size()) {
+        minify *= 0.5f;
+        level++;
+    }
+    return &mips[level];
+}
+
+// ---- манифест мод-каталога
+// Формат text_replace/mod.index (плоский, little-endian, можно mmap'ить):
+//   IndexHeader, затем count x IndexEntry, отсортированных по sig.
+// Лежит рядом с mod/, а не внутри, чтобы запись не меняла mtime каталога.
+static const char* kModDir   = "text_replace/mod";
+static const char* kIndexPath = "text_replace/mod.index";
+static constexpr uint32_t kIndexVersion = 1;
+static constexpr auto kIndexRecheck = std::chrono::seconds(2);
+
+struct IndexHeader {
+    char     magic[4];   // "MRIX"
+    uint32_t version;
+    int64_t  dirStamp;   // mtime каталога mod/ на момент сканирования
+    uint32_t count;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(IndexHeader) == 24 && sizeof(IndexEntry) == 16, "manifest layout");
+
+static inline uint64_t EntrySig(const IndexEntry& e) { return MakeSig(e.h64, e.fmt, e.w, e.h); }
+
+static bool ModDirStamp(int64_t& stamp)
+{
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time(kModDir, ec);
+    if (ec) return false;
+    stamp = (int64_t)t.time_since_epoch().count();
+    return true;
+}
+
+static void ScanModDir(std::vector<IndexEntry>& out)
+{
+    out.clear();
+    std::error_code ec;
+    std::filesystem::directory_iterator it(kModDir, ec), end;
+    if (ec) return;
+
+    for (; it != end; it.increment(ec)) {
+        if (ec) break;
+        if (!it->is_regular_file(ec)) continue;
+
+        // <HASH16>_fmt<F>_<W>x<H>.png
+        const std::string name = it->path().filename().string();
+        unsigned long long h64 = 0;
+        unsigned fmt = 0;
+        int ow = 0, oh = 0;
+        char ext[8] = {};
+        if (std::sscanf(name.c_str(), "%16llX_fmt%u_%dx%d.%7s", &h64, &fmt, &ow, &oh, ext) != 5)
+            continue;
+        if (std::string(ext) != "png" || ow <= 0 || oh <= 0 || ow > 0xFFFF || oh > 0xFFFF) continue;
+
+        out.push_back({ (uint64_t)h64, fmt, (uint16_t)ow, (uint16_t)oh });
+    }
+
+    std::sort(out.begin(), out.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return EntrySig(a) < EntrySig(b);
+    });
+}
+
+static bool ReadIndexFile(int64_t stamp, std::vector<IndexEntry>& out)
+{
+    FILE* f = std::fopen(kIndexPath, "rb");
+    if (!f) return false;
+
+    IndexHeader hdr{};
+    bool ok = std::fread(&hdr, sizeof(hdr), 1, f) == 1
+           && std::memcmp(hdr.magic, "MRIX", 4) == 0
+           && hdr.version == kIndexVersion
+           && hdr.dirStamp == stamp;
+    if (ok) {
+        // битый или обрезанный индекс не должен заставлять нас верить count
+        long pos = std::ftell(f);
+        ok = pos >= 0 && std::fseek(f, 0, SEEK_END) == 0;
+        long end = ok ? std::ftell(f) : -1;
+        ok = ok && end >= pos && (uint64_t)hdr.count * sizeof(IndexEntry) == (uint64_t)(end - pos)
+                && std::fseek(f, pos, SEEK_SET) == 0;
+    }
+    if (ok) {
+        out.resize(hdr.count);
+        ok = hdr.count == 0 || std::fread(out.data(), sizeof(IndexEntry), hdr.count, f) == hdr.count;
+    }
+    std::fclose(f);
+    return ok;
+}
+
+static void WriteIndexFile(int64_t stamp, const std::vector<IndexEntry>& entries)
+{
+    FILE* f = std::fopen(kIndexPath, "wb");
+    if (!f) return;
+
+    IndexHeader hdr{};
+    std::memcpy(hdr.magic, "MRIX", 4);
+    hdr.version  = kIndexVersion;
+    hdr.dirStamp = stamp;
+    hdr.count    = (uint32_t)entries.size();
+    std::fwrite(&hdr, sizeof(hdr), 1, f);
+    if (!entries.empty()) std::fwrite(entries.data(), sizeof(IndexEntry), entries.size(), f);
+    std::fclose(f);
+}
+
+// Пересобирает индекс, только если mtime каталога изменился. Зовётся с воркера,
+// gReplMx берётся лишь на проверку и подмену готового набора.
+static void RefreshIndex()
+{
+    int64_t stamp = 0;
+    bool haveDir = ModDirStamp(stamp);
+
+    {
+        std::lock_guard<std::mutex> lk(gReplMx);
+        if (gIndexReady && haveDir && stamp == gIndexStamp) {
+            gIndexQueued = false;
+            gIndexCheckedAt = std::chrono::steady_clock::now();
+            return;
+        }
+    }
+
+    std::vector<IndexEntry> entries;
+    if (haveDir && !ReadIndexFile(stamp, entries)) {
+        ScanModDir(entries);
+        WriteIndexFile(stamp, entries);
+    }
+
+    std::unordered_map<uint64_t, IndexEntry> idx;
+    idx.reserve(entries.size() * 2);
+    for (const IndexEntry& e : entries) idx.emplace(EntrySig(e), e);
+
+    std::lock_guard<std::mutex> lk(gReplMx);
+    gIndex.swap(idx);
+    gMissing.clear();
+    gIndexStamp = stamp;
+    gIndexReady = true;
+    gIndexQueued = false;
+    gIndexCheckedAt = std::chrono::steady_clock::now();
+}
+
+// ---- фоновый пул декодирования PNG
+// Рендер никогда не ждёт stbi_load: пока задача в очереди, FindOrLoadByHash
+// отдаёт nullptr и рисуется оригинальная DS-текстура; на следующем кадре
+// после окончания декода замена подхватывается через обычный бинд.
+struct LoadJob {
+    enum Kind : uint8_t { Decode, Rescan, Migrate };
+    Kind kind;
+    uint64_t sig;
+    uint64_t h64;
+    uint32_t fmt;
+    int ow, oh;
+    uint32_t gen;
+    uint64_t oldH64 = 0; // только для Migrate
+};
+
+class DecodePool {
+public:
+    ~DecodePool() { Stop(); }
+
+    // вызывать под gReplMx (порядок локов: gReplMx -> Mx)
+    void Push(const LoadJob& job)
+    {
+        {
+            std::lock_guard<std::mutex> lk(Mx);
+            if (Workers.empty()) Start();
+            Jobs.push_back(job);
+        }
+        Cv.notify_one();
+    }
+
+    // true, если среди выброшенных была задача пересканирования
+    bool Drop()
+    {
+        std::lock_guard<std::mutex> lk(Mx);
+        bool rescan = std::any_of(Jobs.begin(), Jobs.end(),
+                                  [](const LoadJob& j){ return j.kind == LoadJob::Rescan; });
+        Jobs.clear();
+        return rescan;
+    }
+
+private:
+    void Start()
+    {
+        unsigned n = std::thread::hardware_concurrency() / 2;
+        if (n < 1) n = 1;
+        if (n > 4) n = 4;
+        for (unsigned i = 0; i < n; ++i)
+            Workers.emplace_back([this]{ Run(); });
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(Mx);
+            Quit = true;
+            Jobs.clear();
+        }
+        Cv.notify_all();
+        for (auto& t : Workers) t.join();
+        Workers.clear();
+    }
+
+    void Run()
+    {
+        for (;;) {
+            LoadJob job;
+            {
+                std::unique_lock<std::mutex> lk(Mx);
+                Cv.wait(lk, [this]{ return Quit || !Jobs.empty(); });
+                if (Quit) return;
+                job = Jobs.front();
+                Jobs.pop_front();
+            }
+
+            if (job.kind == LoadJob::Migrate) {
+                RenameLegacy(job);
+                continue;
+            }
+            if (job.kind == LoadJob::Rescan) {
+                RefreshIndex();
+                QueueAllIndexed(job.gen);
+                continue;
+            }
+
+            // декод без локов — это и есть те самые 20–200 мс
+            auto R = LoadPNGFor(job.h64, job.fmt, job.ow, job.oh);
+
+            std::lock_guard<std::mutex> lk(gReplMx);
+            if (job.gen != gGeneration) continue; // ROM сменился, результат никому не нужен
+            gPending.erase(job.sig);
+            if (R) {
+                gResidentBytes += ResidentBytes(*R);
+                gByHash.emplace(job.sig, std::move(R));
+                EnforceBudget(job.sig);
+            }
+            else gMissing.insert(job.sig);        // битый PNG — больше не пробуем
+        }
+    }
+
+    static void QueueAllIndexed(uint32_t gen);
+
+    static void RenameLegacy(const LoadJob& job)
+    {
+        for (const char* dir : { "text_replace/dump", "text_replace/mod" }) {
+            char from[512], to[512];
+            std::snprintf(from, sizeof(from), "%s/%016llX_fmt%u_%dx%d.png",
+                          dir, (unsigned long long)job.oldH64, job.fmt, job.ow, job.oh);
+            std::snprintf(to, sizeof(to), "%s/%016llX_fmt%u_%dx%d.png",
+                          dir, (unsigned long long)job.h64, job.fmt, job.ow, job.oh);
+
+            std::error_code ec;
+            if (!std::filesystem::exists(from, ec) || std::filesystem::exists(to, ec)) continue;
+            std::filesystem::rename(from, to, ec);
+            if (!ec) Platform::Log(Platform::LogLevel::Info, "TexReplace: migrated %s -> %s\n", from, to);
+        }
+    }
+
+    std::mutex              Mx;
+    std::condition_variable Cv;
+    std::deque<LoadJob>     Jobs;
+    std::vector<std::thread> Workers;
+    bool                    Quit = false;
+};
+
+// объявлен после gReplMx/gByHash: разрушается раньше них и успевает дождаться воркеров
+static DecodePool gDecodePool;
+
+// под gReplMx
+static void QueueLoad(uint64_t sig, uint64_t h64, uint32_t fmt, int ow, int oh)
+{
+    if (!gPending.insert(sig).second) return; // уже в очереди
+    gDecodePool.Push({ LoadJob::Decode, sig, h64, fmt, ow, oh, gGeneration });
+}
+
+// под gReplMx; проверка mtime каталога не чаще раза в kIndexRecheck
+static void MaybeQueueRescan(bool prewarm)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (prewarm) gPrewarmWanted = true;
+
+    // одно пересканирование за раз: иначе два воркера пишут mod.index одновременно.
+    // Прогрев, пришедший во время пересканирования, выполнится по его окончании.
+    if (gIndexQueued) return;
+    if (!prewarm && gIndexReady && now - gIndexCheckedAt < kIndexRecheck) return;
+
+    gIndexQueued = true;
+    gIndexCheckedAt = now;
+    gDecodePool.Push({ LoadJob::Rescan, 0, 0, 0, 0, 0, gGeneration });
+}
+
+void DecodePool::QueueAllIndexed(uint32_t gen)
+{
+    std::lock_guard<std::mutex> lk(gReplMx);
+    if (gen != gGeneration || !gPrewarmWanted) return;
+    gPrewarmWanted = false;
+    for (const auto& [sig, e] : gIndex) {
+        if (gByHash.count(sig) || gMissing.count(sig)) continue;
+        QueueLoad(sig, e.h64, e.fmt, e.w, e.h);
+    }
+}
+
 // Публичные функции (зови из рендера)
 std::shared_ptr<ReplacementTex> FindOrLoadByHash(uint64_t h64, uint32_t fmt, int ow, int oh)
 {
@@ -66,37 +522,504 @@ std::shared_ptr<ReplacementTex> FindOrLoadByHash(uint64_t h64, uint32_t fmt, int
     uint64_t sig = MakeSig(h64, fmt, (uint16_t)ow, (uint16_t)oh);
     if (auto it = gByHash.find(sig); it != gByHash.end()) return it->second;
 
-    auto R = LoadPNGFor(h64, fmt, ow, oh);
-    if (R) gByHash.emplace(sig, R);
-    return R;
+    // промах: файловую систему не трогаем, решает индекс
+    MaybeQueueRescan(false);
+    if (!gIndexReady) return nullptr;                 // индекс ещё строится
+    if (!gIndex.count(sig) || gMissing.count(sig))    // негативный кэш
+        return nullptr;
+
+    // "pending": рисуем оригинал, пока пул не декодирует PNG
+    QueueLoad(sig, h64, fmt, ow, oh);
+    return nullptr;
 }
 
-std::shared_ptr<ReplacementTex> GetBound(uint32_t vramaddr, uint32_t texparam, uint32_t texpal)
+void MigrateLegacyKey(uint64_t oldH64, uint64_t newH64, uint32_t fmt, int w, int h)
 {
-    if (!TexReplace_ReplaceEnabled())     // <- добавь это
-        return nullptr;
+    if (oldH64 == newH64) return;
+    LoadJob job{ LoadJob::Migrate, 0, newH64, fmt, w, h, 0 };
+    job.oldH64 = oldH64;
+    gDecodePool.Push(job);
+}
 
+void TexReplace_PrewarmAll()
+{
     std::lock_guard<std::mutex> lk(gReplMx);
-    uint64_t bk = MakeBindKey(vramaddr, texparam, texpal);
-    auto it = gBind.find(bk);
-    if (it == gBind.end()) return nullptr;
-    return it->second.lock();
+    MaybeQueueRescan(true);
+}
+
+// ---- ReplBindTable
+void ReplBindTable::Begin()
+{
+    Pending.clear();
 }
 
-void BindReplacement(uint32_t vramaddr, uint32_t texparam, uint32_t texpal,
-                     const std::shared_ptr<ReplacementTex>& R)
+void ReplBindTable::Bind(uint32_t texparam, uint32_t texpal, std::shared_ptr<ReplacementTex> R)
+{
+    if (R) Pending.emplace_back(Key(texparam, texpal), std::move(R));
+}
+
+void ReplBindTable::Publish()
+{
+    // пишем в буфер, который сейчас не опубликован; его читатели закончили ещё в прошлом кадре
+    Snapshot& snap = Buffers[Current.load(std::memory_order_relaxed) == &Buffers[0] ? 1 : 0];
+
+    u32 cap = 16;
+    while (cap < Pending.size() * 2) cap <<= 1;
+
+    snap.Slots.assign(cap, Slot{ 0, nullptr });
+    snap.Mask = cap - 1;
+    snap.Keep.clear();
+    snap.Keep.reserve(Pending.size());
+
+    for (auto& [key, R] : Pending) {
+        u32 i = Hash(key) & snap.Mask;
+        while (snap.Slots[i].Key != 0 && snap.Slots[i].Key != key)
+            i = (i + 1) & snap.Mask;
+        snap.Slots[i] = { key, R.get() };
+        snap.Keep.push_back(std::move(R));  // держит текстуры живыми, пока снимок опубликован
+    }
+    Pending.clear();
+
+    Current.store(&snap, std::memory_order_release);
+}
+
+void ReplBindTable::DropEvicted()
+{
+    for (Snapshot& snap : Buffers) {
+        // ключ слота остаётся, чтобы не рвать цепочки проб; Lookup вернёт nullptr
+        for (Slot& slot : snap.Slots)
+            if (slot.Tex && slot.Tex->evicted.load(std::memory_order_acquire)) slot.Tex = nullptr;
+
+        snap.Keep.erase(std::remove_if(snap.Keep.begin(), snap.Keep.end(), [](const auto& R) {
+            return R->evicted.load(std::memory_order_acquire);
+        }), snap.Keep.end());
+    }
+}
+
+uint32_t TexReplace_Generation() { return gGeneration.load(std::memory_order_acquire); }
+
+// ---- фоновая запись дампов
+// Рендер только кладёт RGBA в ограниченную очередь; PNG-кодирование и запись — в отдельном потоке.
+// Если очередь переполнена, дамп отбрасывается (и текстура сможет дампнуться позже), рендер не ждёт.
+static constexpr size_t kDumpQueueBytes = 64u << 20;
+
+// Формат text_replace/dump.pack (little-endian):
+//   записи: PackRecord + PNG-байты, подряд;
+//   в конце: count x PackIndexEntry + PackFooter.
+// При дозаписи хвост-индекс читается и отрезается; если его нет (аварийное завершение),
+// индекс восстанавливается проходом по заголовкам записей.
+static const char* kDumpPackPath = "text_replace/dump.pack";
+static constexpr uint32_t kPackRecordMagic = 0x4B50544D; // "MTPK"
+static constexpr uint32_t kPackFooterMagic = 0x5849544D; // "MTIX"
+
+struct PackRecord {
+    uint32_t magic;
+    uint32_t fmt;
+    uint64_t h64;
+    uint16_t w, h;
+    uint32_t size;     // байт PNG за заголовком
+};
+
+struct PackIndexEntry {
+    uint64_t h64;
+    uint32_t fmt;
+    uint16_t w, h;
+    uint64_t offset;   // смещение PNG-байтов от начала файла
+    uint32_t size;
+    uint32_t reserved;
+};
+
+struct PackFooter {
+    uint64_t indexOffset;
+    uint32_t count;
+    uint32_t magic;
+};
+static_assert(sizeof(PackRecord) == 24 && sizeof(PackIndexEntry) == 32 && sizeof(PackFooter) == 16, "pack layout");
+
+static std::mutex                   gDumpMx;
+static std::unordered_set<uint64_t> gSeen3DTex;  // уже дампнутые: ключ = MakeSig
+
+class DumpWriter {
+public:
+    ~DumpWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lk(Mx);
+            Quit = true;   // очередь дописываем до конца — дампы не терять
+        }
+        Cv.notify_all();
+        if (Worker.joinable()) Worker.join();
+        ClosePack();
+    }
+
+    bool Push(uint64_t h64, uint32_t fmt, int w, int h, const std::vector<uint8_t>& rgba)
+    {
+        {
+            std::lock_guard<std::mutex> lk(Mx);
+            if (QueuedBytes + rgba.size() > kDumpQueueBytes) {
+                Dropped++;
+                return false;
+            }
+            if (!Worker.joinable()) Worker = std::thread([this]{ Run(); });
+            Jobs.push_back({ h64, fmt, w, h, rgba });
+            QueuedBytes += rgba.size();
+        }
+        Cv.notify_one();
+        return true;
+    }
+
+    TexDumpStats Stats()
+    {
+        std::lock_guard<std::mutex> lk(Mx);
+        return { Written, Dropped, (uint32_t)Jobs.size() };
+    }
+
+private:
+    struct Job {
+        uint64_t h64;
+        uint32_t fmt;
+        int w, h;
+        std::vector<uint8_t> rgba;
+    };
+
+    void Run()
+    {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lk(Mx);
+                Cv.wait_for(lk, std::chrono::seconds(1), [this]{ return Quit || !Jobs.empty(); });
+                if (Jobs.empty()) {
+                    if (Quit) return;
+                    // пак выключили — дописываем индекс, чтобы файл был целым
+                    if (Pack && !TexReplace_DumpPackEnabled()) { lk.unlock(); ClosePack(); }
+                    continue;
+                }
+                job = std::move(Jobs.front());
+                Jobs.pop_front();
+                QueuedBytes -= job.rgba.size();
+            }
+
+            EnsureDump3DDir();
+            bool ok = TexReplace_DumpPackEnabled() ? WritePacked(job) : WritePNG(job);
+
+            std::lock_guard<std::mutex> lk(Mx);
+            if (ok) Written++;
+        }
+    }
+
+    static bool WritePNG(const Job& job)
+    {
+        char fname[256];
+        std::snprintf(fname, sizeof(fname), "text_replace/dump/%016llX_fmt%u_%dx%d.png",
+                      (unsigned long long)job.h64, job.fmt, job.w, job.h);
+        return stbi_write_png(fname, job.w, job.h, 4, job.rgba.data(), job.w*4) != 0;
+    }
+
+    bool WritePacked(const Job& job)
+    {
+        if (!Pack && !OpenPack()) return false;
+        // уже лежит в паке с прошлых запусков (пак открывается лениво, после проверки gSeen3DTex)
+        if (!PackSigs.insert(MakeSig(job.h64, job.fmt, (uint16_t)job.w, (uint16_t)job.h)).second)
+            return false;
+
+        int len = 0;
+        unsigned char* png = stbi_write_png_to_mem(job.rgba.data(), job.w*4, job.w, job.h, 4, &len);
+        if (!png) return false;
+
+        PackRecord rec{ kPackRecordMagic, job.fmt, job.h64, (uint16_t)job.w, (uint16_t)job.h, (uint32_t)len };
+        std::fseek(Pack, (long)PackEnd, SEEK_SET);
+        bool ok = std::fwrite(&rec, sizeof(rec), 1, Pack) == 1
+               && std::fwrite(png, 1, len, Pack) == (size_t)len;
+        STBIW_FREE(png);
+        if (!ok) return false;
+
+        PackIndex.push_back({ job.h64, job.fmt, (uint16_t)job.w, (uint16_t)job.h,
+                              PackEnd + sizeof(rec), (uint32_t)len, 0 });
+        PackEnd += sizeof(rec) + len;
+        return true;
+    }
+
+    bool OpenPack()
+    {
+        Pack = std::fopen(kDumpPackPath, "r+b");
+        if (!Pack) Pack = std::fopen(kDumpPackPath, "w+b");
+        if (!Pack) return false;
+
+        PackIndex.clear();
+        PackEnd = 0;
+
+        std::fseek(Pack, 0, SEEK_END);
+        uint64_t fileSize = (uint64_t)std::ftell(Pack);
+
+        PackFooter foot{};
+        if (fileSize >= sizeof(foot)) {
+            std::fseek(Pack, (long)(fileSize - sizeof(foot)), SEEK_SET);
+            if (std::fread(&foot, sizeof(foot), 1, Pack) != 1) foot = {};
+        }
+
+        if (foot.magic == kPackFooterMagic &&
+            foot.indexOffset + (uint64_t)foot.count * sizeof(PackIndexEntry) + sizeof(foot) == fileSize) {
+            PackIndex.resize(foot.count);
+            std::fseek(Pack, (long)foot.indexOffset, SEEK_SET);
+            if (foot.count && std::fread(PackIndex.data(), sizeof(PackIndexEntry), foot.count, Pack) != foot.count)
+                PackIndex.clear();
+            else
+                PackEnd = foot.indexOffset;
+        }
+
+        if (PackEnd == 0) {
+            // индекса нет — восстанавливаем по заголовкам записей
+            PackIndex.clear();
+            std::fseek(Pack, 0, SEEK_SET);
+            PackRecord rec;
+            while (std::fread(&rec, sizeof(rec), 1, Pack) == 1 && rec.magic == kPackRecordMagic
+                   && PackEnd + sizeof(rec) + rec.size <= fileSize) {
+                PackIndex.push_back({ rec.h64, rec.fmt, rec.w, rec.h, PackEnd + sizeof(rec), rec.size, 0 });
+                PackEnd += sizeof(rec) + rec.size;
+                std::fseek(Pack, (long)PackEnd, SEEK_SET);
+            }
+        }
+
+        // старый индекс/обрывок будет перезаписан при закрытии
+        std::fflush(Pack);
+        std::error_code ec;
+        std::filesystem::resize_file(kDumpPackPath, PackEnd, ec);
+
+        PackSigs.clear();
+        for (const PackIndexEntry& e : PackIndex)
+            PackSigs.insert(MakeSig(e.h64, e.fmt, e.w, e.h));
+
+        std::lock_guard<std::mutex> lk(gDumpMx);
+        gSeen3DTex.insert(PackSigs.begin(), PackSigs.end());
+        return true;
+    }
+
+    void ClosePack()
+    {
+        if (!Pack) return;
+
+        PackFooter foot{ PackEnd, (uint32_t)PackIndex.size(), kPackFooterMagic };
+        std::fseek(Pack, (long)PackEnd, SEEK_SET);
+        if (!PackIndex.empty())
+            std::fwrite(PackIndex.data(), sizeof(PackIndexEntry), PackIndex.size(), Pack);
+        std::fwrite(&foot, sizeof(foot), 1, Pack);
+        std::fclose(Pack);
+        Pack = nullptr;
+    }
+
+    std::mutex              Mx;
+    std::condition_variable Cv;
+    std::deque<Job>         Jobs;
+    size_t                  QueuedBytes = 0;
+    uint64_t                Written = 0, Dropped = 0;
+    std::thread             Worker;
+    bool                    Quit = false;
+
+    // только поток записи (и деструктор после join)
+    FILE*                       Pack = nullptr;
+    uint64_t                    PackEnd = 0;
+    std::vector<PackIndexEntry> PackIndex;
+    std::unordered_set<uint64_t> PackSigs;
+};
+
+static DumpWriter gDumpWriter;
+
+void DumpTexture(uint64_t h64, uint32_t fmt, int w, int h, const std::vector<uint8_t>& rgba)
+{
+    uint64_t sig = MakeSig(h64, fmt, (uint16_t)w, (uint16_t)h);
+    {
+        std::lock_guard<std::mutex> lk(gDumpMx);
+        if (!gSeen3DTex.insert(sig).second) return;
+    }
+
+    if (!gDumpWriter.Push(h64, fmt, w, h, rgba)) {
+        // очередь полна: пропускаем, но даём шанс при следующем появлении текстуры
+        std::lock_guard<std::mutex> lk(gDumpMx);
+        gSeen3DTex.erase(sig);
+    }
+}
+
+TexDumpStats TexReplace_GetDumpStats() { return gDumpWriter.Stats(); }
+
+// ---- TexReplaceCache
+void TexReplaceCache::Invalidate(const GPU& gpu, const uint64_t* texDirty, const uint64_t* palDirty,
+                                 ReplBindTable& binds)
+{
+    gUseClock.fetch_add(1, std::memory_order_relaxed); // вызывается раз в кадр — это и есть часы LRU
+
+    // выселенные текстуры держат только наши ссылки: отпускаем их здесь, а не в Resolve,
+    // иначе текстура, которую больше не рисуют, никогда не освободится
+    uint32_t serial = gEvictSerial.load(std::memory_order_acquire);
+    if (serial != EvictSerial) {
+        EvictSerial = serial;
+        for (auto& [key, e] : Cache)
+            if (e.Repl && e.Repl->evicted.load(std::memory_order_acquire)) e.Repl.reset();
+        binds.DropEvicted();
+    }
+
+    if (!texDirty && !palDirty) return;
+
+    for (auto it = Cache.begin(); it != Cache.end();) {
+        Entry& e = it->second;
+        bool stale = false;
+
+        if (texDirty) {
+            for (int i = 0; i < 2 && !stale; i++) {
+                if (e.TextureRAMSize[i])
+                    stale = TexcacheCheckInvalid(e.TextureRAMStart[i], e.TextureRAMSize[i], e.TextureHash[i],
+                                                 texDirty, gpu.VRAMFlat_Texture, sizeof(gpu.VRAMFlat_Texture));
+            }
+        }
+        if (!stale && palDirty && e.TexPalSize > 0)
+            stale = TexcacheCheckInvalid(e.TexPalStart, e.TexPalSize, e.TexPalHash,
+                                         palDirty, gpu.VRAMFlat_TexPal, sizeof(gpu.VRAMFlat_TexPal));
+
+        if (stale) it = Cache.erase(it);
+        else       ++it;
+    }
+}
+
+// ---- ключ замены по сырой VRAM
+static void HashWrapped(XXH3_state_t* st, const u8* vram, u32 vramSize, u32 addr, u32 size)
+{
+    addr &= (vramSize - 1);
+    while (size > 0) {
+        u32 piece = std::min(size, vramSize - addr);
+        XXH3_64bits_update(st, &vram[addr], piece);
+        addr = (addr + piece) & (vramSize - 1);
+        size -= piece;
+    }
+}
+
+// 4x4-сжатые текстуры: Texcache берёт под палитру 64 КБ с запасом, а для ключа нужен
+// ровно тот кусок, на который ссылаются блоки — иначе ключ "плывёт" от чужих палитр
+static u32 CompressedPalSize(const GPU& gpu, u32 slot1addr, u32 numBlocks)
+{
+    u32 maxOffset = 0;
+    for (u32 i = 0; i < numBlocks; i++) {
+        u16 palinfo = gpu.ReadVRAMFlat_Texture<u16>(slot1addr + i*2);
+        maxOffset = std::max<u32>(maxOffset, palinfo & 0x3FFF);
+    }
+    // каждый блок читает 4 цвета (8 байт) с байтового смещения (palinfo & 0x3FFF) << 2
+    return maxOffset * 4 + 8;
+}
+
+uint64_t TexReplace_HashVRAM(const GPU& gpu, uint32_t texparam, uint32_t texpal)
+{
+    u32 fmt = (texparam >> 26) & 7;
+    TextureVRAMRanges ranges = GetTextureVRAMRanges(texparam, texpal);
+
+    // размер/формат/color0 в сид, остальное (wrap, flip, texgen) на содержимое не влияет
+    u32 seed = (texparam >> 20) & 0x3FF;
+    if (fmt == 5 || fmt == 7) seed &= ~(1u << 9);
+
+    XXH3_state_t st;
+    XXH3_64bits_reset_withSeed(&st, seed);
+
+    for (int i = 0; i < 2; i++)
+        if (ranges.TextureRAMSize[i])
+            HashWrapped(&st, gpu.VRAMFlat_Texture, sizeof(gpu.VRAMFlat_Texture),
+                        ranges.TextureRAMStart[i], ranges.TextureRAMSize[i]);
+
+    u32 palSize = ranges.TexPalSize;
+    if (fmt == 5)
+        palSize = CompressedPalSize(gpu, ranges.TextureRAMStart[1], ranges.TextureRAMSize[1] / 2);
+    if (palSize)
+        HashWrapped(&st, gpu.VRAMFlat_TexPal, sizeof(gpu.VRAMFlat_TexPal), ranges.TexPalStart, palSize);
+
+    return XXH3_64bits_digest(&st);
+}
+
+TexReplaceCache::Entry& TexReplaceCache::Lookup(const GPU& gpu, uint32_t texparam, uint32_t texpal)
+{
+    uint32_t gen = TexReplace_Generation();
+    if (gen != Generation) {  // сменился ROM — старые замены не валидны
+        Cache.clear();
+        Generation = gen;
+    }
+
+    uint64_t key = TexcacheKey(texparam, texpal);
+    if (auto it = Cache.find(key); it != Cache.end()) return it->second;
+
+    TextureVRAMRanges ranges = GetTextureVRAMRanges(texparam, texpal);
+
+    Entry e{};
+    for (int i = 0; i < 2; i++) {
+        e.TextureRAMStart[i] = ranges.TextureRAMStart[i];
+        e.TextureRAMSize[i]  = ranges.TextureRAMSize[i];
+        if (e.TextureRAMSize[i])
+            e.TextureHash[i] = TexcacheMaskedHash(gpu.VRAMFlat_Texture, sizeof(gpu.VRAMFlat_Texture),
+                                                  e.TextureRAMStart[i], e.TextureRAMSize[i]);
+    }
+    e.TexPalStart = ranges.TexPalStart;
+    e.TexPalSize  = ranges.TexPalSize;
+    if (e.TexPalSize)
+        e.TexPalHash = TexcacheMaskedHash(gpu.VRAMFlat_TexPal, sizeof(gpu.VRAMFlat_TexPal),
+                                          e.TexPalStart, e.TexPalSize);
+
+    e.H64 = TexReplace_HashVRAM(gpu, texparam, texpal);
+    e.Fmt = (texparam >> 26) & 7;
+    e.W = (int)TextureWidth(texparam);
+    e.H = (int)TextureHeight(texparam);
+
+    return Cache.emplace(key, std::move(e)).first->second;
+}
+
+bool TexReplaceCache::WantsRGBA(const Entry& e) const
+{
+    return (TexReplace_DumpEnabled() && !e.Dumped)
+        || (TexReplace_MigrateEnabled() && !e.Migrated);
+}
+
+void TexReplaceCache::ConsumeRGBA(Entry& e, const std::vector<uint8_t>& rgba)
+{
+    const bool valid = rgba.size() == (size_t)e.W * e.H * 4;
+
+    if (TexReplace_DumpEnabled() && !e.Dumped) {
+        if (valid) DumpTexture(e.H64, e.Fmt, e.W, e.H, rgba);
+        e.Dumped = true;
+    }
+    if (TexReplace_MigrateEnabled() && !e.Migrated) {
+        if (valid) MigrateLegacyKey(fnv1a64_quarterTL_rgba(rgba.data(), e.W, e.H), e.H64, e.Fmt, e.W, e.H);
+        e.Migrated = true;
+    }
+}
+
+std::shared_ptr<ReplacementTex> TexReplaceCache::Resolve(Entry& e)
+{
+    // выселенную отпускаем, иначе память не освободится; FindOrLoadByHash поставит её на перезагрузку
+    if (e.Repl && e.Repl->evicted.load(std::memory_order_acquire)) e.Repl.reset();
+    if (!e.Repl) e.Repl = FindOrLoadByHash(e.H64, e.Fmt, e.W, e.H);
+    if (e.Repl) e.Repl->lastUse.store(gUseClock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return e.Repl;
+}
+
+void   TexReplace_SetMemoryBudget(size_t bytes) { gBudget.store(bytes, std::memory_order_relaxed); }
+size_t TexReplace_MemoryBudget() { return gBudget.load(std::memory_order_relaxed); }
+
+TexMemStats TexReplace_GetMemStats()
 {
-    if (!R) return;
     std::lock_guard<std::mutex> lk(gReplMx);
-    uint64_t bk = MakeBindKey(vramaddr, texparam, texpal);
-    gBind[bk] = R;
+    return { gResidentBytes, (uint32_t)gByHash.size(), gEvictedCount };
 }
 
 void ClearAllReplacements()    // вызови при загрузке ROM/Reset
 {
     std::lock_guard<std::mutex> lk(gReplMx);
+    for (auto& [sig, R] : gByHash) R->evicted.store(true, std::memory_order_release);
     gByHash.clear();
-    gBind.clear();
+    gEvictSerial.fetch_add(1, std::memory_order_release);
+    gResidentBytes = 0;
+    gPending.clear();
+    gMissing.clear();
+    ++gGeneration;
+    // пересканирование, которое уже идёт на воркере, Drop не останавливает:
+    // флаг снимет оно само, иначе следующее запустится параллельно с ним
+    if (gDecodePool.Drop())
+        gIndexQueued = false;
+    gPrewarmWanted = false;
+    gIndexCheckedAt = {};   // новый ROM — повод сверить каталог
 }
 
 } // namespace melonDS
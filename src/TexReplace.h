@@ -6,6 +6,7 @@
 #include <mutex>
 #include <cstdint>
 #include <atomic>
+#include <unordered_map>
 
 #if __cplusplus >= 201703L
   #include <filesystem>
@@ -20,21 +21,34 @@
 
 namespace melonDS {
 
+class GPU;
+
 inline std::atomic<bool> gEnableTexReplace{false};
 inline std::atomic<bool> gEnable3DTexDump{false};
+inline std::atomic<bool> gEnableTexPrewarm{false};
+inline std::atomic<bool> gEnableTexMigrate{false};
+inline std::atomic<bool> gEnableTexDumpPack{false};
 
 // удобные геттеры/сеттеры (объявления)
 bool TexReplace_ReplaceEnabled();
 void TexReplace_SetReplace(bool v);
 bool TexReplace_DumpEnabled();
 void TexReplace_SetDump(bool v);
+// дампы в один индексированный text_replace/dump.pack вместо россыпи PNG
+bool TexReplace_DumpPackEnabled();
+void TexReplace_SetDumpPack(bool v);
+bool TexReplace_MigrateEnabled();
+void TexReplace_SetMigrate(bool v);
+bool TexReplace_PrewarmEnabled();
+void TexReplace_SetPrewarm(bool v);
 
-static std::once_flag gDumpDirOnce;
+// Ставит в фоновую очередь декод всех PNG из text_replace/mod/ (зови при загрузке ROM)
+void TexReplace_PrewarmAll();
 
-// Набор уже дампнутых текстур (уникальность по содержимому)
-static std::unordered_set<uint64_t> gSeen3DTex;  // ключ = комбинированный хэш
+static std::once_flag gDumpDirOnce;
 
-// FNV-1a 64, только верхняя-левая четверть RGBA-изображения
+// Старая схема ключей (до XXH3 по VRAM): FNV-1a 64 по верхней половине декодированного RGBA.
+// Осталась только для миграции паков, см. TexReplace_SetMigrate.
 static inline uint64_t fnv1a64_quarterTL_rgba(const uint8_t* rgba,
                                               int width, int height,
                                               int strideBytes = 0) // по умолчанию = width*4
@@ -87,17 +101,172 @@ static inline void EnsureDump3DDir()
 }
 
 
+// Уровень mip-цепочки для SoftRenderer. Тексели уже в формате рендера (r6 | g6<<8 | b6<<16 | a5<<24)
+// и лежат тайлами 4x4: 16 текселей = 64 байта = одна кэш-линия.
+struct ReplMipLevel {
+    int w = 0, h = 0;
+    int tilesW = 0;
+    float sx = 1.0f, sy = 1.0f;   // пикселей уровня на один DS-тексель
+    std::vector<uint32_t> texels;
+
+    uint32_t Fetch(int x, int y) const
+    {
+        return texels[((((y >> 2) * tilesW) + (x >> 2)) << 4) | ((y & 3) << 2) | (x & 3)];
+    }
+};
+
 struct ReplacementTex {
     int w = 0, h = 0;
+    int ow = 0, oh = 0;               // размер DS-текстуры
     float sx = 1.0f, sy = 1.0f;
-    std::vector<uint8_t> rgba;
-    mutable uint32_t gltex = 0;
+    std::vector<uint8_t> rgba;        // остаётся и после заливки в GL: другой рендерер (или контекст) может залить заново
+
+    // для LRU-бюджета: кадр последнего использования и признак выселения из кэша.
+    // Выселенную текстуру кэши рендереров отпускают и при надобности грузят заново.
+    mutable std::atomic<uint32_t> lastUse{0};
+    mutable std::atomic<bool>     evicted{false};
+
+    ReplacementTex() = default;
+    ReplacementTex(const ReplacementTex&) = delete;
+    ReplacementTex& operator=(const ReplacementTex&) = delete;
+
+    // Для SoftRenderer: цепочка от разрешения DS-текстуры (или исходного, если оно меньше)
+    // вниз до 1x1, с box-фильтром. Уровни крупнее DS-текстуры не нужны: софт-рендер
+    // сэмплирует по целым DS-текселям. Строится при первом PickMip, так что с GL-рендером
+    // не тратит ни время декода, ни бюджет памяти.
+    mutable std::vector<ReplMipLevel> mips;   // пишется под gReplMx, см. ResidentBytes
+    mutable std::once_flag mipsBuilt;
+
+    // minify — сколько DS-текселей приходится на пиксель экрана у данного полигона
+    const ReplMipLevel* PickMip(float minify) const;
 };
 
-void ClearBindings(); 
+// Не блокирует: если PNG ещё декодируется в фоне, вернёт nullptr ("pending")
 std::shared_ptr<ReplacementTex> FindOrLoadByHash(uint64_t h64, uint32_t fmt, int ow, int oh);
-std::shared_ptr<ReplacementTex> GetBound(uint32_t vramaddr, uint32_t texparam, uint32_t texpal);
-void BindReplacement(uint32_t vramaddr, uint32_t texparam, uint32_t texpal,
-                     const std::shared_ptr<ReplacementTex>& R);
 void ClearAllReplacements();
+// Растёт на каждом ClearAllReplacements — по нему кэши рендереров понимают, что всё устарело
+uint32_t TexReplace_Generation();
+
+// Ключ замены: XXH3 по сырым texel- и palette-диапазонам VRAM (VRAMFlat_* должны быть coherent).
+// Не зависит от декодера и не требует декода в RGBA.
+uint64_t TexReplace_HashVRAM(const GPU& gpu, uint32_t texparam, uint32_t texpal);
+
+// Фоново переименовывает <old>_fmt.. -> <new>_fmt.. в dump/ и mod/, если старый файл есть, а нового нет
+void MigrateLegacyKey(uint64_t oldH64, uint64_t newH64, uint32_t fmt, int w, int h);
+
+// PNG в text_replace/dump/ (или в dump.pack), один раз на содержимое+формат+размер.
+// Не блокирует: кодирование и запись в фоновом потоке, при переполнении очереди дамп отбрасывается.
+void DumpTexture(uint64_t h64, uint32_t fmt, int w, int h, const std::vector<uint8_t>& rgba);
+
+// Бюджет памяти под декодированные замены (байты). При превышении выселяются
+// давно не использованные текстуры; те, что рисовались в последних кадрах, не трогаются.
+void   TexReplace_SetMemoryBudget(size_t bytes);
+size_t TexReplace_MemoryBudget();
+
+
+struct TexMemStats {
+    uint64_t residentBytes;
+    uint32_t resident;  // текстур в кэше сейчас
+    uint64_t evicted;   // выселено за всё время
+};
+TexMemStats TexReplace_GetMemStats();
+
+struct TexDumpStats {
+    uint64_t written;
+    uint64_t dropped;   // отброшено из-за переполненной очереди
+    uint32_t queued;
+};
+TexDumpStats TexReplace_GetDumpStats();
+
+// Привязка (texparam, texpal) -> замена на кадр. Строится в PASS 1 и публикуется
+// подменой указателя (RCU: неактивный буфер переписывается только на следующем кадре),
+// поэтому в PASS 2 поиск на каждый полигон идёт без локов и без счётчиков shared_ptr.
+class ReplBindTable
+{
+public:
+    void Begin();
+    void Bind(uint32_t texparam, uint32_t texpal, std::shared_ptr<ReplacementTex> R);
+    void Publish();
+    // отпускает выселенные текстуры из обоих буферов; только между кадрами, когда Lookup никто не зовёт
+    void DropEvicted();
+
+    const ReplacementTex* Lookup(uint32_t texparam, uint32_t texpal) const
+    {
+        const Snapshot* snap = Current.load(std::memory_order_acquire);
+        if (!snap || snap->Keep.empty()) return nullptr;
+
+        uint64_t key = Key(texparam, texpal);
+        for (uint32_t i = Hash(key) & snap->Mask;; i = (i + 1) & snap->Mask) {
+            const Slot& slot = snap->Slots[i];
+            if (slot.Key == key) return slot.Tex;
+            if (slot.Key == 0) return nullptr;
+        }
+    }
+
+private:
+    // у текстурированного полигона формат != 0, так что ключ 0 свободен под пустой слот
+    static uint64_t Key(uint32_t texparam, uint32_t texpal) { return ((uint64_t)texpal << 32) | texparam; }
+    static uint32_t Hash(uint64_t key) { return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32); }
+
+    struct Slot
+    {
+        uint64_t Key;
+        const ReplacementTex* Tex;
+    };
+
+    struct Snapshot
+    {
+        std::vector<Slot> Slots;
+        uint32_t Mask = 0;
+        std::vector<std::shared_ptr<ReplacementTex>> Keep;
+    };
+
+    Snapshot Buffers[2];
+    std::atomic<const Snapshot*> Current{nullptr};
+    std::vector<std::pair<uint64_t, std::shared_ptr<ReplacementTex>>> Pending;
+};
+
+// Кэш привязки (vramaddr, texparam, texpal) -> хэш содержимого -> замена, по экземпляру на рендерер.
+// Декод в RGBA и хэш считаются только при первом появлении текстуры; сбрасываются записи
+// только через VRAMDirty_Texture / VRAMDirty_TexPal, как в Texcache::Update.
+class TexReplaceCache
+{
+public:
+    struct Entry
+    {
+        uint32_t TextureRAMStart[2], TextureRAMSize[2];
+        uint32_t TexPalStart, TexPalSize;
+        uint64_t TextureHash[2];
+        uint64_t TexPalHash;
+
+        uint64_t H64 = 0;      // ключ замены
+        uint32_t Fmt = 0;
+        int W = 0, H = 0;
+        bool Dumped = false;
+        bool Migrated = false;
+        std::shared_ptr<ReplacementTex> Repl;
+    };
+
+    // вызывать после MakeVRAMFlat_*Coherent; nullptr — эта память не менялась.
+    // Заодно отпускает выселенные замены, в том числе из таблицы привязок рендерера.
+    void Invalidate(const GPU& gpu, const uint64_t* texDirty, const uint64_t* palDirty, ReplBindTable& binds);
+
+    // находит или заводит запись; ключ считается по VRAM, без декода
+    Entry& Lookup(const GPU& gpu, uint32_t texparam, uint32_t texpal);
+
+    // нужен ли этой записи декод в RGBA (дамп и/или миграция ещё не сделаны)
+    bool WantsRGBA(const Entry& e) const;
+    // дамп/миграция по декодированному RGBA; пустой rgba — декод не удался, больше не пробуем
+    void ConsumeRGBA(Entry& e, const std::vector<uint8_t>& rgba);
+
+    // пока замена грузится в фоне (или её нет) — nullptr, спрашиваем снова на следующем кадре
+    std::shared_ptr<ReplacementTex> Resolve(Entry& e);
+
+    void Reset() { Cache.clear(); }
+
+private:
+    std::unordered_map<uint64_t, Entry> Cache;
+    uint32_t Generation = 0;
+    uint32_t EvictSerial = 0;
+};
 }
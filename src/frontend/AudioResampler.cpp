@@ -0,0 +1,228 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RESAMPLER_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define RESAMPLER_NEON
+#endif
+
+#include "AudioResampler.h"
+
+using namespace melonDS;
+
+// how far dynamic rate control may pull the ratio, and how hard
+// 0.5% is below what anyone can hear as a pitch change
+static constexpr double MaxRateAdjust = 0.005;
+static constexpr double RateAdjustSmoothing = 0.05;
+
+AudioResampler::AudioResampler()
+{
+    Setup(32823.6328125, 48000);
+}
+
+void AudioResampler::Setup(double inRate, double outRate, int maxInFrames)
+{
+    OutRate = outRate;
+    BaseStep = inRate / outRate;
+    RateAdjust = 1.0;
+    Step = BaseStep;
+
+    // cut off a bit below whichever Nyquist frequency is lower
+    double cutoff = std::min(1.0, outRate / inRate) * 0.92;
+
+    Coefs.assign(NumPhases * Taps * 2, 0.f);
+    Deltas.assign(NumPhases * Taps * 2, 0.f);
+
+    auto phase = [&](double frac, double* out)
+    {
+        double sum = 0;
+        for (int k = 0; k < Taps; k++)
+        {
+            // distance from the output position, in input frames
+            double x = (k - (Taps/2 - 1)) - frac;
+            double u = x / (Taps/2);
+            double sinc = (x == 0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double window = (fabs(u) >= 1.0) ? 0.0 : (0.42 + 0.5 * cos(M_PI * u) + 0.08 * cos(2 * M_PI * u));
+
+            out[k] = sinc * window;
+            sum += out[k];
+        }
+
+        // unity gain at DC for every phase
+        for (int k = 0; k < Taps; k++)
+            out[k] /= sum;
+    };
+
+    double cur[Taps], next[Taps];
+    phase(0.0, cur);
+    for (int p = 0; p < NumPhases; p++)
+    {
+        phase((p + 1) / (double)NumPhases, next);
+
+        float* c = &Coefs[p * Taps * 2];
+        float* d = &Deltas[p * Taps * 2];
+        for (int k = 0; k < Taps; k++)
+        {
+            c[k*2] = c[k*2+1] = (float)cur[k];
+            d[k*2] = d[k*2+1] = (float)(next[k] - cur[k]);
+        }
+
+        memcpy(cur, next, sizeof(cur));
+    }
+
+    // what's left over between calls stays under Taps frames plus one step,
+    // 2*Taps is plenty even when fast-forwarding
+    Pending.clear();
+    Pending.reserve((maxInFrames + Taps * 2) * 2);
+
+    Reset();
+}
+
+void AudioResampler::Reset()
+{
+    // start with silence in the filter's history
+    Pending.assign((Taps/2) * 2, 0.f);
+    Pos = 0;
+}
+
+void AudioResampler::SetInputRate(double inRate)
+{
+    BaseStep = inRate / OutRate;
+    Step = BaseStep * RateAdjust;
+}
+
+void AudioResampler::UpdateFillLevel(int buffered, int target)
+{
+    if (target <= 0) return;
+
+    double error = (buffered - target) / (double)target;
+    double wanted = 1.0 + std::clamp(error * MaxRateAdjust, -MaxRateAdjust, MaxRateAdjust);
+
+    RateAdjust += (wanted - RateAdjust) * RateAdjustSmoothing;
+    Step = BaseStep * RateAdjust;
+}
+
+int AudioResampler::InputFramesNeeded(int outFrames) const
+{
+    if (outFrames < 1) return 0;
+
+    double last = Pos + (outFrames - 1) * Step;
+    int needed = (int)ceil(last) + Taps - (int)(Pending.size() / 2);
+    return std::max(needed, 0);
+}
+
+void AudioResampler::Process(const s16* in, int inFrames, s16* out, int outFrames, int volume)
+{
+    if (outFrames < 1) return;
+
+    // stay within the room reserved by Setup()
+    size_t start = Pending.size();
+    inFrames = std::min(inFrames, (int)((Pending.capacity() - start) / 2));
+    Pending.resize(start + inFrames * 2);
+    for (int i = 0; i < inFrames * 2; i++)
+        Pending[start + i] = in[i];
+
+    int numframes = Pending.size() / 2;
+    double maxpos = numframes - Taps;
+    if (maxpos < Pos)
+    {
+        // not even one output's worth: wait for more
+        memset(out, 0, outFrames * 2 * sizeof(s16));
+        return;
+    }
+
+    // on an underrun, stretch what there is rather than repeating a frame
+    double step = Step;
+    if (outFrames > 1 && Pos + (outFrames - 1) * step > maxpos)
+        step = (maxpos - Pos) / (outFrames - 1);
+
+    const float* src = Pending.data();
+    float vol = volume / 256.f;
+
+#if defined(RESAMPLER_SSE2)
+    __m128 vvol = _mm_set1_ps(vol);
+#elif defined(RESAMPLER_NEON)
+    float32x4_t vvol = vdupq_n_f32(vol);
+#endif
+
+    double pos = Pos;
+    for (int i = 0; i < outFrames; i++, pos += step)
+    {
+        int ipos = (int)pos;
+        float phasepos = (float)((pos - ipos) * NumPhases);
+        int p = std::min((int)phasepos, NumPhases - 1);
+        float pf = phasepos - p;
+
+        const float* x = &src[ipos * 2];
+        const float* c = &Coefs[p * Taps * 2];
+        const float* d = &Deltas[p * Taps * 2];
+
+#if defined(RESAMPLER_SSE2)
+        __m128 vpf = _mm_set1_ps(pf);
+        __m128 acc = _mm_setzero_ps();
+        for (int k = 0; k < Taps * 2; k += 4)
+        {
+            __m128 coef = _mm_add_ps(_mm_loadu_ps(c + k), _mm_mul_ps(_mm_loadu_ps(d + k), vpf));
+            acc = _mm_add_ps(acc, _mm_mul_ps(coef, _mm_loadu_ps(x + k)));
+        }
+
+        // lanes are L R L R, fold them and pack with saturation
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        __m128i res = _mm_cvtps_epi32(_mm_mul_ps(acc, vvol));
+        res = _mm_packs_epi32(res, res);
+        u32 frame = (u32)_mm_cvtsi128_si32(res);
+        memcpy(&out[i * 2], &frame, sizeof(frame));
+#elif defined(RESAMPLER_NEON)
+        float32x4_t vpf = vdupq_n_f32(pf);
+        float32x4_t acc = vdupq_n_f32(0.f);
+        for (int k = 0; k < Taps * 2; k += 4)
+        {
+            float32x4_t coef = vmlaq_f32(vld1q_f32(c + k), vld1q_f32(d + k), vpf);
+            acc = vmlaq_f32(acc, coef, vld1q_f32(x + k));
+        }
+
+        float32x2_t lr = vmul_f32(vadd_f32(vget_low_f32(acc), vget_high_f32(acc)), vget_low_f32(vvol));
+        int16x4_t res = vqmovn_s32(vcombine_s32(vcvtn_s32_f32(lr), vdup_n_s32(0)));
+        out[i * 2] = vget_lane_s16(res, 0);
+        out[i * 2 + 1] = vget_lane_s16(res, 1);
+#else
+        float l = 0, r = 0;
+        for (int k = 0; k < Taps; k++)
+        {
+            float coef = c[k*2] + d[k*2] * pf;
+            l += coef * x[k*2];
+            r += coef * x[k*2+1];
+        }
+
+        out[i * 2] = (s16)std::clamp((int)lrintf(l * vol), -32768, 32767);
+        out[i * 2 + 1] = (s16)std::clamp((int)lrintf(r * vol), -32768, 32767);
+#endif
+    }
+
+    // drop the frames no later output can reach
+    int consumed = std::min((int)pos, numframes);
+    Pending.erase(Pending.begin(), Pending.begin() + consumed * 2);
+    Pos = pos - consumed;
+}
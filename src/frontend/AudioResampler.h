@@ -0,0 +1,80 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef AUDIORESAMPLER_H
+#define AUDIORESAMPLER_H
+
+#include <vector>
+
+#include "types.h"
+
+// Converts the SPU's stereo output to the host device rate.
+//
+// Polyphase windowed-sinc FIR: Taps input frames per output frame, with the
+// coefficients for the fractional position interpolated between NumPhases
+// precomputed phases. Filter state carries over between Process() calls,
+// so block boundaries don't click.
+//
+// The ratio follows the upstream fill level (dynamic rate control): when
+// too much audio is queued it is consumed slightly faster, and vice versa,
+// so producer and device clock drift never turns into under- or overruns.
+class AudioResampler
+{
+public:
+    AudioResampler();
+
+    // builds the filter for the given nominal rates and clears any state
+    // maxInFrames is the most input a single Process() call will get: room for
+    // it is reserved here, as Process() runs in the audio callback and mustn't allocate
+    void Setup(double inRate, double outRate, int maxInFrames = 4096);
+    void Reset();
+
+    // changes the input rate without rebuilding the filter (fast-forward, slow-mo)
+    void SetInputRate(double inRate);
+
+    // buffered: frames waiting upstream after the last read
+    // target: where that amount should settle
+    void UpdateFillLevel(int buffered, int target);
+
+    // input frames the next Process() call needs to produce outFrames
+    int InputFramesNeeded(int outFrames) const;
+
+    // always produces exactly outFrames frames
+    // if the input falls short, the available audio is stretched over them
+    // input past the room reserved by Setup() is dropped
+    void Process(const melonDS::s16* in, int inFrames, melonDS::s16* out, int outFrames, int volume);
+
+private:
+    static constexpr int Taps = 16;
+    static constexpr int NumPhases = 256;
+
+    // per phase, Taps coefficients each duplicated for both channels,
+    // and the difference to the next phase
+    std::vector<float> Coefs;
+    std::vector<float> Deltas;
+
+    std::vector<float> Pending; // stereo frames not consumed yet
+    double Pos;                 // position of the next output in Pending, in frames
+
+    double OutRate;
+    double BaseStep;
+    double RateAdjust;
+    double Step;
+};
+
+#endif // AUDIORESAMPLER_H
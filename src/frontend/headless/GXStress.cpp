@@ -0,0 +1,188 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+
+#include "GXStress.h"
+#include "NDS.h"
+
+using namespace melonDS;
+
+// where the display list goes in main RAM, and the DMA channel that sends it
+static constexpr u32 DisplayListAddr = 0x02300000;
+static constexpr u32 DMAChannelRegs = 0x040000B0;
+
+static s32 ToFixed(double v)
+{
+    return (s32)(v * 4096.0);
+}
+
+u32 GXStress::Random()
+{
+    // xorshift, so the sequence doesn't depend on the C library
+    RNG ^= RNG << 13;
+    RNG ^= RNG >> 7;
+    RNG ^= RNG << 17;
+    return (u32)(RNG >> 11);
+}
+
+void GXStress::Setup(NDS& nds)
+{
+    // power everything on, 3D on BG0 of the main engine
+    nds.ARM9IOWrite16(0x04000304, 0x820F);
+    nds.ARM9IOWrite32(0x04000000, 0x10108);
+    nds.ARM9IOWrite16(0x04000008, 0x0000);
+
+    FillVRAM(nds, 0x30000);
+}
+
+void GXStress::FillVRAM(NDS& nds, u32 words)
+{
+    // banks A and B hold textures, E holds palettes
+    // map them to LCDC to write them, then back
+    nds.ARM9IOWrite8(0x04000240, 0x80);
+    nds.ARM9IOWrite8(0x04000241, 0x80);
+    nds.ARM9IOWrite8(0x04000244, 0x80);
+
+    for (u32 i = 0; i < words; i++)
+    {
+        u32 bank = Random(3);
+        u32 addr;
+        if (bank == 0)      addr = 0x06800000 + Random(0x8000)*4;
+        else if (bank == 1) addr = 0x06820000 + Random(0x8000)*4;
+        else                addr = 0x06880000 + Random(0x4000)*4;
+        u32 lo = Random();
+        u32 hi = Random();
+        nds.ARM9Write32(addr, lo ^ (hi << 16));
+    }
+
+    nds.ARM9IOWrite8(0x04000240, 0x83);
+    nds.ARM9IOWrite8(0x04000241, 0x8B);
+    nds.ARM9IOWrite8(0x04000244, 0x83);
+}
+
+void GXStress::AddPolygon()
+{
+    auto cmd = [this](u32 c) { DisplayList.push_back(c); };
+    auto cmdp = [this](u32 c, u32 p) { DisplayList.push_back(c); DisplayList.push_back(p); };
+
+    // the random values are drawn one per statement, as the order of
+    // evaluation within an expression is up to the compiler
+
+    // mostly regular polygons, the rest shadow volumes
+    u32 mode = (Random(16) < 13) ? Random(3) : 3;
+    u32 alpha = (Random(10) < 6) ? 31 : ((Random(20) == 0) ? 0 : (1 + Random(30)));
+    u32 id = (Random(4) == 0) ? 0 : Random(64);
+    u32 attr = (mode << 4) | (3 << 6) | (alpha << 16) | (id << 24);
+    attr |= Random(2) << 11;            // translucent depth update
+    attr |= (Random(20) == 0) << 13;    // draw far 1-dot polygons
+    attr |= (Random(10) == 0) << 14;    // depth test equal
+    attr |= Random(2) << 15;            // fog
+    if (Random(4) == 0) attr |= (1<<12); // clip polygons crossing the far plane
+    cmdp(0x29, attr);
+
+    u32 format = (Random(5) == 0) ? 0 : (1 + Random(7));
+    u32 sizes = Random(5);
+    u32 sizet = Random(5);
+    u32 texparam = (sizes << 20) | (sizet << 23) | (format << 26);
+    texparam |= Random(0x10000);        // address
+    texparam |= Random(16) << 16;       // repeat/flip
+    texparam |= Random(2) << 29;        // colour 0 transparent
+    cmdp(0x2A, texparam);
+    cmdp(0x2B, Random(0x2000));
+
+    // triangles, quads, and strips of both
+    u32 prim = Random(4);
+    int nverts;
+    if (prim == 0)      nverts = 3;
+    else if (prim == 1) nverts = 4;
+    else if (prim == 2) nverts = 3 + Random(4);
+    else                nverts = 4 + 2*Random(3);
+    cmdp(0x40, prim);
+
+    // somewhere in the view frustum, some of them large
+    double cz = -(1.0 + Random(5000) / 1000.0);
+    double cx = ((s32)Random(2000) - 1000) / 1000.0 * -cz * 0.9;
+    double cy = ((s32)Random(2000) - 1000) / 1000.0 * -cz * 0.7;
+    double size = (Random(4) == 0) ? 1.5 : 0.4;
+    size *= Random(1000) / 1000.0 + 0.05;
+
+    for (int v = 0; v < nverts; v++)
+    {
+        cmdp(0x20, Random() & 0x7FFF);
+
+        // texcoords reach past the texture, for the repeat/flip/clamp modes
+        s32 s = (s32)Random(8 << (sizes + 4)) - (2 << (sizes + 4));
+        s32 t = (s32)Random(8 << (sizet + 4)) - (2 << (sizet + 4));
+        cmdp(0x22, (s & 0xFFFF) | (t << 16));
+
+        double vx = cx + ((s32)Random(2000) - 1000) / 1000.0 * size;
+        double vy = cy + ((s32)Random(2000) - 1000) / 1000.0 * size;
+        double vz = cz + ((s32)Random(2000) - 1000) / 1000.0 * size;
+        vz = std::clamp(vz, -7.9, -0.3);
+        cmd(0x23);
+        cmd((ToFixed(vx) & 0xFFFF) | (ToFixed(vy) << 16));
+        cmd(ToFixed(vz) & 0xFFFF);
+    }
+
+    cmd(0x41);
+}
+
+void GXStress::Frame(NDS& nds)
+{
+    if ((FrameNum++ % 16) == 15)
+        FillVRAM(nds, 64 + Random(2048));
+
+    // DISP3DCNT, clear colour/depth, fog, toon and edge tables
+    nds.ARM9IOWrite16(0x04000060, Random(0x1000) & 0x0FFF);
+    nds.ARM9IOWrite32(0x04000350, Random() & 0x3F1F7FFF);
+    nds.ARM9IOWrite32(0x04000354, 0x7FFF - Random(0x400));
+    nds.ARM9IOWrite8(0x04000340, Random(32));
+    for (int i = 0; i < 8; i++)
+        nds.ARM9IOWrite16(0x04000330 + i*2, Random() & 0x7FFF);
+    nds.ARM9IOWrite32(0x04000358, Random() & 0x001F7FFF);
+    nds.ARM9IOWrite16(0x0400035C, Random() & 0x7FFF);
+    for (int i = 0; i < 32; i++)
+        nds.ARM9IOWrite8(0x04000360 + i, Random(128));
+    for (int i = 0; i < 32; i++)
+        nds.ARM9IOWrite16(0x04000380 + i*2, Random() & 0x7FFF);
+
+    DisplayList.clear();
+
+    // viewport, and a perspective projection with a 60 degree field of view
+    DisplayList.insert(DisplayList.end(), {0x60, 0xBFFF0000, 0x10, 0, 0x16});
+    const double proj[16] = {1.299,0,0,0, 0,1.732,0,0, 0,0,-1.0645,-1, 0,0,-1.032,0};
+    for (int i = 0; i < 16; i++)
+        DisplayList.push_back((u32)ToFixed(proj[i]));
+    DisplayList.insert(DisplayList.end(), {0x10, 2, 0x15});
+
+    int npolys = 40 + Random(260);
+    for (int i = 0; i < npolys; i++)
+        AddPolygon();
+
+    // SWAP_BUFFERS, with random sorting and depth modes
+    DisplayList.insert(DisplayList.end(), {0x50, Random(4)});
+
+    for (size_t i = 0; i < DisplayList.size(); i++)
+        nds.ARM9Write32(DisplayListAddr + i*4, DisplayList[i]);
+
+    // geometry FIFO DMA, 32-bit, destination fixed
+    nds.ARM9IOWrite32(DMAChannelRegs, DisplayListAddr);
+    nds.ARM9IOWrite32(DMAChannelRegs + 4, 0x04000400);
+    nds.ARM9IOWrite32(DMAChannelRegs + 8, (u32)DisplayList.size() | 0x80000000 | (7u << 27) | (1u << 26) | (2u << 21));
+}
@@ -0,0 +1,62 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef GXSTRESS_H
+#define GXSTRESS_H
+
+#include <vector>
+
+#include "types.h"
+
+namespace melonDS
+{
+class NDS;
+}
+
+// Random 3D workload for the benchmark runner.
+//
+// Before every frame, it randomizes the 3D rendering registers and DMAs a
+// display list of random polygons to the geometry FIFO: all primitive types,
+// every texture format with random parameters, translucency, wireframe,
+// shadow volumes, fog and edge marking. Texture VRAM is refilled with random
+// data every now and then, so texture caches see changes as well.
+// The sequence only depends on the seed, so two builds running it produce
+// the same frames if their 3D renderers agree.
+//
+// The ROM keeps running underneath, it should leave the 3D engine alone.
+class GXStress
+{
+public:
+    explicit GXStress(melonDS::u64 seed = 0x12345678ABCDEFull) : RNG(seed) {}
+
+    void Setup(melonDS::NDS& nds);
+    void Frame(melonDS::NDS& nds);
+
+private:
+    melonDS::u32 Random();
+    melonDS::u32 Random(melonDS::u32 max) { return Random() % max; }
+
+    void FillVRAM(melonDS::NDS& nds, melonDS::u32 words);
+    void AddPolygon();
+
+    melonDS::u64 RNG;
+    int FrameNum = 0;
+    std::vector<melonDS::u32> DisplayList;
+};
+
+#endif // GXSTRESS_H
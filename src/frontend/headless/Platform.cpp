@@ -0,0 +1,440 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Platform implementation for the headless benchmark runner: plain C/C++
+// standard library only, no saves written back, no networking, no camera.
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Platform.h"
+
+#ifdef __WIN32__
+#define fseek _fseeki64
+#define ftell _ftelli64
+#endif // __WIN32__
+
+namespace melonDS::Platform
+{
+
+LogLevel HeadlessLogLevel = LogLevel::Info;
+
+static const auto StartTime = std::chrono::steady_clock::now();
+
+void SignalStop(StopReason reason, void* userdata)
+{
+}
+
+
+static std::string GetModeString(FileMode mode, bool file_exists)
+{
+    std::string modeString;
+
+    if (mode & FileMode::Append)
+        modeString += 'a';
+    else if (!(mode & FileMode::Write))
+        modeString += 'r';
+    else if ((mode & FileMode::NoCreate) || ((mode & FileMode::Preserve) && file_exists))
+        modeString += 'r';
+    else
+        modeString += 'w';
+
+    if ((mode & FileMode::ReadWrite) == FileMode::ReadWrite)
+        modeString += '+';
+
+    if (!(mode & FileMode::Text))
+        modeString += 'b';
+
+    return modeString;
+}
+
+FileHandle* OpenFile(const std::string& path, FileMode mode)
+{
+    if ((mode & (FileMode::ReadWrite | FileMode::Append)) == FileMode::None)
+    {
+        Log(LogLevel::Error, "Attempted to open \"%s\" in neither read nor write mode (FileMode 0x%x)\n", path.c_str(), mode);
+        return nullptr;
+    }
+
+    std::error_code ec;
+    bool exists = std::filesystem::exists(path, ec);
+    if ((mode & FileMode::NoCreate) && !exists)
+        return nullptr;
+
+    std::string modeString = GetModeString(mode, exists);
+    FILE* file = fopen(path.c_str(), modeString.c_str());
+    if (!file)
+    {
+        Log(LogLevel::Debug, "Failed to open \"%s\" (effective mode \"%s\")\n", path.c_str(), modeString.c_str());
+        return nullptr;
+    }
+
+    return reinterpret_cast<FileHandle *>(file);
+}
+
+std::string GetLocalFilePath(const std::string& filename)
+{
+    return filename;
+}
+
+FileHandle* OpenLocalFile(const std::string& path, FileMode mode)
+{
+    return OpenFile(GetLocalFilePath(path), mode);
+}
+
+bool CloseFile(FileHandle* file)
+{
+    return fclose(reinterpret_cast<FILE *>(file)) == 0;
+}
+
+bool IsEndOfFile(FileHandle* file)
+{
+    return feof(reinterpret_cast<FILE *>(file)) != 0;
+}
+
+bool FileReadLine(char* str, int count, FileHandle* file)
+{
+    return fgets(str, count, reinterpret_cast<FILE *>(file)) != nullptr;
+}
+
+bool FileExists(const std::string& name)
+{
+    std::error_code ec;
+    return std::filesystem::is_regular_file(name, ec);
+}
+
+bool LocalFileExists(const std::string& name)
+{
+    return FileExists(GetLocalFilePath(name));
+}
+
+bool CheckFileWritable(const std::string& filepath)
+{
+    // the runner never writes anything back
+    return false;
+}
+
+bool CheckLocalFileWritable(const std::string& filepath)
+{
+    return false;
+}
+
+bool FileSeek(FileHandle* file, s64 offset, FileSeekOrigin origin)
+{
+    int stdorigin;
+    switch (origin)
+    {
+        case FileSeekOrigin::Start: stdorigin = SEEK_SET; break;
+        case FileSeekOrigin::Current: stdorigin = SEEK_CUR; break;
+        case FileSeekOrigin::End: stdorigin = SEEK_END; break;
+    }
+
+    return fseek(reinterpret_cast<FILE *>(file), offset, stdorigin) == 0;
+}
+
+void FileRewind(FileHandle* file)
+{
+    rewind(reinterpret_cast<FILE *>(file));
+}
+
+u64 FileRead(void* data, u64 size, u64 count, FileHandle* file)
+{
+    return fread(data, size, count, reinterpret_cast<FILE *>(file));
+}
+
+bool FileFlush(FileHandle* file)
+{
+    return fflush(reinterpret_cast<FILE *>(file)) == 0;
+}
+
+u64 FileWrite(const void* data, u64 size, u64 count, FileHandle* file)
+{
+    return fwrite(data, size, count, reinterpret_cast<FILE *>(file));
+}
+
+u64 FileWriteFormatted(FileHandle* file, const char* fmt, ...)
+{
+    if (fmt == nullptr)
+        return 0;
+
+    va_list args;
+    va_start(args, fmt);
+    u64 ret = vfprintf(reinterpret_cast<FILE *>(file), fmt, args);
+    va_end(args);
+    return ret;
+}
+
+u64 FileLength(FileHandle* file)
+{
+    FILE* stdfile = reinterpret_cast<FILE *>(file);
+    long pos = ftell(stdfile);
+    fseek(stdfile, 0, SEEK_END);
+    long len = ftell(stdfile);
+    fseek(stdfile, pos, SEEK_SET);
+    return len;
+}
+
+void Log(LogLevel level, const char* fmt, ...)
+{
+    if (fmt == nullptr || level < HeadlessLogLevel)
+        return;
+
+    // stdout is reserved for the results
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+Thread* Thread_Create(std::function<void()> func)
+{
+    return (Thread*) new std::thread(std::move(func));
+}
+
+void Thread_Free(Thread* thread)
+{
+    std::thread* t = (std::thread*) thread;
+    if (t->joinable())
+        t->detach();
+    delete t;
+}
+
+void Thread_Wait(Thread* thread)
+{
+    std::thread* t = (std::thread*) thread;
+    if (t->joinable())
+        t->join();
+}
+
+struct HeadlessSemaphore
+{
+    std::mutex Mx;
+    std::condition_variable Cv;
+    int Count = 0;
+};
+
+Semaphore* Semaphore_Create()
+{
+    return (Semaphore*) new HeadlessSemaphore();
+}
+
+void Semaphore_Free(Semaphore* sema)
+{
+    delete (HeadlessSemaphore*) sema;
+}
+
+void Semaphore_Reset(Semaphore* sema)
+{
+    HeadlessSemaphore* s = (HeadlessSemaphore*) sema;
+    std::lock_guard<std::mutex> lk(s->Mx);
+    s->Count = 0;
+}
+
+void Semaphore_Wait(Semaphore* sema)
+{
+    HeadlessSemaphore* s = (HeadlessSemaphore*) sema;
+    std::unique_lock<std::mutex> lk(s->Mx);
+    s->Cv.wait(lk, [s]{ return s->Count > 0; });
+    s->Count--;
+}
+
+bool Semaphore_TryWait(Semaphore* sema, int timeout_ms)
+{
+    HeadlessSemaphore* s = (HeadlessSemaphore*) sema;
+    std::unique_lock<std::mutex> lk(s->Mx);
+    if (!s->Cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [s]{ return s->Count > 0; }))
+        return false;
+    s->Count--;
+    return true;
+}
+
+void Semaphore_Post(Semaphore* sema, int count)
+{
+    HeadlessSemaphore* s = (HeadlessSemaphore*) sema;
+    {
+        std::lock_guard<std::mutex> lk(s->Mx);
+        s->Count += count;
+    }
+    s->Cv.notify_all();
+}
+
+Mutex* Mutex_Create()
+{
+    return (Mutex*) new std::mutex();
+}
+
+void Mutex_Free(Mutex* mutex)
+{
+    delete (std::mutex*) mutex;
+}
+
+void Mutex_Lock(Mutex* mutex)
+{
+    ((std::mutex*) mutex)->lock();
+}
+
+void Mutex_Unlock(Mutex* mutex)
+{
+    ((std::mutex*) mutex)->unlock();
+}
+
+bool Mutex_TryLock(Mutex* mutex)
+{
+    return ((std::mutex*) mutex)->try_lock();
+}
+
+void Sleep(u64 usecs)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(usecs));
+}
+
+u64 GetMSCount()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+u64 GetUSCount()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+
+void WriteNDSSave(const u8* savedata, u32 savelen, u32 writeoffset, u32 writelen, void* userdata)
+{
+}
+
+void WriteGBASave(const u8* savedata, u32 savelen, u32 writeoffset, u32 writelen, void* userdata)
+{
+}
+
+void WriteFirmware(const Firmware& firmware, u32 writeoffset, u32 writelen, void* userdata)
+{
+}
+
+void WriteDateTime(int year, int month, int day, int hour, int minute, int second, void* userdata)
+{
+}
+
+
+void MP_Begin(void* userdata)
+{
+}
+
+void MP_End(void* userdata)
+{
+}
+
+int MP_SendPacket(u8* data, int len, u64 timestamp, void* userdata)
+{
+    return 0;
+}
+
+int MP_RecvPacket(u8* data, u64* timestamp, void* userdata)
+{
+    return 0;
+}
+
+int MP_SendCmd(u8* data, int len, u64 timestamp, void* userdata)
+{
+    return 0;
+}
+
+int MP_SendReply(u8* data, int len, u64 timestamp, u16 aid, void* userdata)
+{
+    return 0;
+}
+
+int MP_SendAck(u8* data, int len, u64 timestamp, void* userdata)
+{
+    return 0;
+}
+
+int MP_RecvHostPacket(u8* data, u64* timestamp, void* userdata)
+{
+    return 0;
+}
+
+u16 MP_RecvReplies(u8* data, u64 timestamp, u16 aidmask, void* userdata)
+{
+    return 0;
+}
+
+
+int Net_SendPacket(u8* data, int len, void* userdata)
+{
+    return 0;
+}
+
+int Net_RecvPacket(u8* data, void* userdata)
+{
+    return 0;
+}
+
+
+void Camera_Start(int num, void* userdata)
+{
+}
+
+void Camera_Stop(int num, void* userdata)
+{
+}
+
+void Camera_CaptureFrame(int num, u32* frame, int width, int height, bool yuv, void* userdata)
+{
+}
+
+bool Addon_KeyDown(KeyType type, void* userdata)
+{
+    return false;
+}
+
+void Addon_RumbleStart(u32 len, void* userdata)
+{
+}
+
+void Addon_RumbleStop(void* userdata)
+{
+}
+
+float Addon_MotionQuery(MotionQueryType type, void* userdata)
+{
+    return 0;
+}
+
+DynamicLibrary* DynamicLibrary_Load(const char* lib)
+{
+    return nullptr;
+}
+
+void DynamicLibrary_Unload(DynamicLibrary* lib)
+{
+}
+
+void* DynamicLibrary_LoadFunction(DynamicLibrary* lib, const char* name)
+{
+    return nullptr;
+}
+
+}
@@ -0,0 +1,521 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Headless benchmark runner: boots a ROM on the core library and runs frames
+// back to back, with no window, no audio device and no frame limiter.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NDS.h"
+#include "NDSCart.h"
+#include "GPU.h"
+#include "GPU3D_Soft.h"
+#include "SPU.h"
+#include "RewindBuffer.h"
+#include "AudioResampler.h"
+#include "GXStress.h"
+#include "Args.h"
+#include "Platform.h"
+
+#define XXH_STATIC_LINKING_ONLY
+#include "xxhash/xxhash.h"
+
+using namespace melonDS;
+
+namespace melonDS::Platform
+{
+extern LogLevel HeadlessLogLevel;
+}
+
+struct BenchOptions
+{
+    std::string ROMPath;
+    std::string BIOS9Path;
+    std::string BIOS7Path;
+    int Frames = 3600;
+    int Warmup = 120;
+    bool Threaded = false;
+    int RasterThreads = 1;
+    bool GXStress = false;
+    bool JIT = false;
+    unsigned JITThreshold = 1;
+    unsigned JITBudget = 0;
+    bool JITBackground = false;
+    std::string JITCachePath;
+    bool Profile = false;
+    unsigned RewindInterval = 0;
+    unsigned RewindBudgetMB = 64;
+    unsigned ResampleRate = 0;
+    std::string HashLogPath;
+    std::string ComparePath;
+};
+
+static void PrintUsage(const char* argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options] <rom.nds>\n"
+        "\n"
+        "  -n, --frames <N>     number of timed frames (default 3600)\n"
+        "  -w, --warmup <N>     frames to run before timing starts (default 120)\n"
+        "      --threaded       render 3D on a separate thread\n"
+        "      --raster-threads <N>\n"
+        "                       share 3D rasterization between N threads (default 1)\n"
+        "      --gx-stress      feed the 3D engine a random scene every frame, for comparing\n"
+        "                       3D renderer builds (the ROM only provides a running system)\n"
+#ifdef JIT_ENABLED
+        "      --jit            enable the JIT recompiler\n"
+        "      --jit-threshold <N>\n"
+        "                       interpret blocks N times before compiling them (default 1)\n"
+        "      --jit-budget <N> compile at most N blocks per frame (default 0, unlimited)\n"
+        "      --jit-background compile blocks on a separate thread\n"
+        "      --jit-cache <path>\n"
+        "                       load and update a persistent JIT block cache\n"
+#endif
+#ifdef FRAME_PROFILER_ENABLED
+        "      --profile        print where host time went, per subsystem and scheduler event\n"
+#endif
+        "      --rewind <N>     keep a rewind snapshot every N frames\n"
+        "      --rewind-budget <MB>\n"
+        "                       memory budget for rewind snapshots (default 64)\n"
+        "      --resample <Hz>  feed the audio output through the frontend resampler\n"
+        "      --hash-log <path>\n"
+        "                       write the hashes of every frame's picture and audio to a file\n"
+        "      --compare <path> check every frame against a hash log from another build or\n"
+        "                       configuration, and fail at the first one that differs\n"
+        "      --bios9 <path>   use an external ARM9 BIOS instead of FreeBIOS\n"
+        "      --bios7 <path>   use an external ARM7 BIOS instead of FreeBIOS\n"
+        "  -q, --quiet          only print errors from the core\n"
+        "  -v, --verbose        also print debug messages from the core\n",
+        argv0);
+}
+
+static bool ParseArgs(int argc, char** argv, BenchOptions& opt)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+
+        if (arg == "-n" || arg == "--frames" || arg == "-w" || arg == "--warmup")
+        {
+            const char* v = value();
+            if (!v) return false;
+            int n = atoi(v);
+            if (n < 0) return false;
+            if (arg == "-n" || arg == "--frames") opt.Frames = n;
+            else opt.Warmup = n;
+        }
+        else if (arg == "--threaded") opt.Threaded = true;
+        else if (arg == "--raster-threads")
+        {
+            const char* v = value();
+            if (!v) return false;
+            int n = atoi(v);
+            if (n < 1 || n > SoftRenderer::MaxRasterThreads) return false;
+            opt.RasterThreads = n;
+        }
+        else if (arg == "--gx-stress") opt.GXStress = true;
+#ifdef JIT_ENABLED
+        else if (arg == "--jit") opt.JIT = true;
+        else if (arg == "--jit-background") opt.JITBackground = true;
+        else if (arg == "--jit-threshold" || arg == "--jit-budget")
+        {
+            const char* v = value();
+            if (!v) return false;
+            int n = atoi(v);
+            if (n < 0) return false;
+            (arg == "--jit-threshold" ? opt.JITThreshold : opt.JITBudget) = n;
+        }
+        else if (arg == "--jit-cache")
+        {
+            const char* v = value();
+            if (!v) return false;
+            opt.JITCachePath = v;
+        }
+#endif
+#ifdef FRAME_PROFILER_ENABLED
+        else if (arg == "--profile") opt.Profile = true;
+#endif
+        else if (arg == "--rewind" || arg == "--rewind-budget")
+        {
+            const char* v = value();
+            if (!v) return false;
+            int n = atoi(v);
+            if (n <= 0) return false;
+            (arg == "--rewind" ? opt.RewindInterval : opt.RewindBudgetMB) = n;
+        }
+        else if (arg == "--resample")
+        {
+            const char* v = value();
+            if (!v) return false;
+            int n = atoi(v);
+            if (n < 8000 || n > 192000) return false;
+            opt.ResampleRate = n;
+        }
+        else if (arg == "--hash-log" || arg == "--compare")
+        {
+            const char* v = value();
+            if (!v) return false;
+            (arg == "--hash-log" ? opt.HashLogPath : opt.ComparePath) = v;
+        }
+        else if (arg == "--bios9" || arg == "--bios7")
+        {
+            const char* v = value();
+            if (!v) return false;
+            (arg == "--bios9" ? opt.BIOS9Path : opt.BIOS7Path) = v;
+        }
+        else if (arg == "-q" || arg == "--quiet") Platform::HeadlessLogLevel = Platform::LogLevel::Error;
+        else if (arg == "-v" || arg == "--verbose") Platform::HeadlessLogLevel = Platform::LogLevel::Debug;
+        else if (arg[0] == '-') return false;
+        else if (opt.ROMPath.empty()) opt.ROMPath = arg;
+        else return false;
+    }
+
+    return !opt.ROMPath.empty() && opt.Frames > 0;
+}
+
+static std::unique_ptr<u8[]> ReadFile(const std::string& path, u32& len)
+{
+    Platform::FileHandle* f = Platform::OpenFile(path, Platform::FileMode::Read);
+    if (!f) return nullptr;
+
+    len = (u32)Platform::FileLength(f);
+    auto data = std::make_unique<u8[]>(len);
+    Platform::FileRewind(f);
+    u64 got = Platform::FileRead(data.get(), len, 1, f);
+    Platform::CloseFile(f);
+    return got == 1 ? std::move(data) : nullptr;
+}
+
+template<typename Image>
+static bool LoadBIOS(const std::string& path, std::unique_ptr<Image>& out)
+{
+    if (path.empty()) return true;
+
+    u32 len = 0;
+    auto data = ReadFile(path, len);
+    if (!data || len != sizeof(Image))
+    {
+        fprintf(stderr, "failed to load BIOS %s\n", path.c_str());
+        return false;
+    }
+
+    out = std::make_unique<Image>();
+    memcpy(out->data(), data.get(), sizeof(Image));
+    return true;
+}
+
+static u64 HashFrame(NDS& nds)
+{
+    int frontbuf = nds.GPU.FrontBuffer;
+    XXH3_state_t* st = XXH3_createState();
+    XXH3_64bits_reset(st);
+    for (int screen = 0; screen < 2; screen++)
+    {
+        if (nds.GPU.Framebuffer[frontbuf][screen])
+            XXH3_64bits_update(st, nds.GPU.Framebuffer[frontbuf][screen].get(), 256 * 192 * 4);
+    }
+    u64 hash = XXH3_64bits_digest(st);
+    XXH3_freeState(st);
+    return hash;
+}
+
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+    // nearest-rank
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+    rank = std::clamp<size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    NDSArgs args {};
+    if (!LoadBIOS(opt.BIOS9Path, args.ARM9BIOS) || !LoadBIOS(opt.BIOS7Path, args.ARM7BIOS))
+        return 1;
+#ifdef JIT_ENABLED
+    if (opt.JIT)
+    {
+        args.JIT = JITArgs {};
+        args.JIT->CompileThreshold = opt.JITThreshold;
+        args.JIT->CompileBudget = opt.JITBudget;
+        args.JIT->BackgroundCompile = opt.JITBackground;
+    }
+#endif
+
+    u32 romlen = 0;
+    auto romdata = ReadFile(opt.ROMPath, romlen);
+    if (!romdata)
+    {
+        fprintf(stderr, "failed to read %s\n", opt.ROMPath.c_str());
+        return 1;
+    }
+
+    auto nds = std::make_unique<NDS>(std::move(args));
+    if (opt.Threaded)
+        static_cast<SoftRenderer&>(nds->GPU.GetRenderer3D()).SetThreaded(true, nds->GPU);
+    if (opt.RasterThreads > 1)
+        static_cast<SoftRenderer&>(nds->GPU.GetRenderer3D()).SetRasterThreads(opt.RasterThreads, nds->GPU);
+
+    auto cart = NDSCart::ParseROM(std::move(romdata), romlen, nullptr);
+    if (!cart)
+    {
+        fprintf(stderr, "failed to parse %s\n", opt.ROMPath.c_str());
+        return 1;
+    }
+
+    nds->Reset();
+    nds->SetNDSCart(std::move(cart));
+    if (!opt.JITCachePath.empty())
+        nds->JIT.LoadPersistentCache(opt.JITCachePath);
+    // fixed clock so that the final frame only depends on the ROM and the frame count
+    nds->RTC.SetDateTime(2000, 1, 1, 0, 0, 0);
+
+    // no BIOS boot: external BIOS/firmware are optional here, and boot animation
+    // frames aren't what we want to measure
+    nds->SetupDirectBoot(opt.ROMPath);
+    nds->Start();
+
+    std::unique_ptr<GXStress> gxStress;
+    if (opt.GXStress)
+    {
+        gxStress = std::make_unique<GXStress>();
+        gxStress->Setup(*nds);
+    }
+
+    // the output buffer is drained and discarded each frame, as an audio device would
+    // with --resample, it is consumed in device-sized blocks like the frontend's callback does
+    using clock = std::chrono::steady_clock;
+    constexpr int deviceBlock = 1024;
+    std::vector<s16> audio(2 * 4096);
+    std::vector<s16> resampled(2 * deviceBlock);
+    XXH3_state_t* audioHash = XXH3_createState();
+    XXH3_64bits_reset(audioHash);
+    u64 audioFrames = 0;
+    AudioResampler resampler;
+    u64 resampledFrames = 0;
+    double resampleMs = 0;
+    if (opt.ResampleRate)
+        resampler.Setup(32823.6328125, opt.ResampleRate, (int)audio.size() / 2);
+
+    // per-frame hashes, to compare the output of two builds or configurations frame by frame
+    // the lines are "<frame> <picture hash> <audio hash>"
+    FILE* hashLog = nullptr;
+    FILE* compareLog = nullptr;
+    if (!opt.HashLogPath.empty() && !(hashLog = fopen(opt.HashLogPath.c_str(), "w")))
+    {
+        fprintf(stderr, "failed to create %s\n", opt.HashLogPath.c_str());
+        return 1;
+    }
+    if (!opt.ComparePath.empty() && !(compareLog = fopen(opt.ComparePath.c_str(), "r")))
+    {
+        fprintf(stderr, "failed to open %s\n", opt.ComparePath.c_str());
+        return 1;
+    }
+    XXH3_state_t* frameAudioHash = XXH3_createState();
+    XXH3_64bits_reset(frameAudioHash);
+    int frameNum = 0;
+    int mismatch = -1;
+
+    auto drainAudio = [&]()
+    {
+        if (!opt.ResampleRate)
+        {
+            int num;
+            while ((num = std::min(nds->SPU.GetOutputSize(), 1024)) > 0)
+            {
+                nds->SPU.ReadOutput(audio.data(), num);
+                XXH3_64bits_update(audioHash, audio.data(), num * 2 * sizeof(s16));
+                XXH3_64bits_update(frameAudioHash, audio.data(), num * 2 * sizeof(s16));
+                audioFrames += num;
+            }
+            return;
+        }
+
+        for (;;)
+        {
+            int needed = std::min(resampler.InputFramesNeeded(deviceBlock), 4096);
+            if (nds->SPU.GetOutputSize() < needed)
+                break;
+
+            int num = nds->SPU.ReadOutput(audio.data(), needed);
+            XXH3_64bits_update(frameAudioHash, audio.data(), num * 2 * sizeof(s16));
+            auto t0 = clock::now();
+            resampler.UpdateFillLevel(nds->SPU.GetOutputSize(), deviceBlock / 2);
+            resampler.Process(audio.data(), num, resampled.data(), deviceBlock, 256);
+            resampleMs += std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+            resampledFrames += deviceBlock;
+        }
+    };
+
+    auto checkFrame = [&]()
+    {
+        if (!hashLog && !compareLog) return;
+
+        u64 video = HashFrame(*nds);
+        u64 sound = XXH3_64bits_digest(frameAudioHash);
+        XXH3_64bits_reset(frameAudioHash);
+
+        if (hashLog)
+            fprintf(hashLog, "%d %016llX %016llX\n", frameNum, (unsigned long long)video, (unsigned long long)sound);
+
+        if (compareLog && mismatch < 0)
+        {
+            int num;
+            unsigned long long refvideo, refsound;
+            if (fscanf(compareLog, "%d %llX %llX", &num, &refvideo, &refsound) != 3 || num != frameNum)
+            {
+                fprintf(stderr, "compare: %s has no frame %d\n", opt.ComparePath.c_str(), frameNum);
+                mismatch = frameNum;
+            }
+            else if (refvideo != video || refsound != sound)
+            {
+                const char* what = (refsound == sound) ? "picture" : ((refvideo == video) ? "audio" : "picture and audio");
+                fprintf(stderr, "compare: frame %d differs (%s)\n", frameNum, what);
+                mismatch = frameNum;
+            }
+        }
+
+        frameNum++;
+    };
+
+    std::unique_ptr<RewindBuffer> rewind;
+    if (opt.RewindInterval)
+        rewind = std::make_unique<RewindBuffer>(opt.RewindInterval, (u64)opt.RewindBudgetMB << 20);
+
+    for (int i = 0; i < opt.Warmup; i++)
+    {
+        if (gxStress) gxStress->Frame(*nds);
+        nds->RunFrame();
+        drainAudio();
+        checkFrame();
+    }
+
+    std::vector<double> frameMs;
+    frameMs.reserve(opt.Frames);
+
+#ifdef FRAME_PROFILER_ENABLED
+    nds->Profiler.Reset();
+#endif
+
+    auto start = clock::now();
+    for (int i = 0; i < opt.Frames; i++)
+    {
+        // the scene is set up outside of the timed part
+        if (gxStress) gxStress->Frame(*nds);
+
+        auto t0 = clock::now();
+        nds->RunFrame();
+        drainAudio();
+        if (rewind) rewind->Frame(*nds);
+        frameMs.push_back(std::chrono::duration<double, std::milli>(clock::now() - t0).count());
+        checkFrame();
+    }
+    double total = std::chrono::duration<double>(clock::now() - start).count();
+
+    if (!opt.JITCachePath.empty())
+        nds->JIT.SavePersistentCache(opt.JITCachePath);
+
+    u64 hash = HashFrame(*nds);
+
+    XXH3_freeState(frameAudioHash);
+    if (hashLog) fclose(hashLog);
+    if (compareLog) fclose(compareLog);
+
+    std::sort(frameMs.begin(), frameMs.end());
+
+    printf("rom:         %s\n", opt.ROMPath.c_str());
+    printf("frames:      %d (+%d warmup)\n", opt.Frames, opt.Warmup);
+    printf("time:        %.3f s\n", total);
+    printf("fps:         %.2f (%.1f%% of 59.83)\n", opt.Frames / total, opt.Frames / total / 59.8261 * 100.0);
+    printf("frame ms:    min %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+           frameMs.front(), Percentile(frameMs, 50), Percentile(frameMs, 90),
+           Percentile(frameMs, 99), frameMs.back());
+    printf("final frame: %016llX\n", (unsigned long long)hash);
+    if (!opt.ResampleRate)
+        printf("audio:       %016llX (%llu frames)\n",
+               (unsigned long long)XXH3_64bits_digest(audioHash), (unsigned long long)audioFrames);
+    XXH3_freeState(audioHash);
+#ifdef JIT_ENABLED
+    if (opt.JIT)
+    {
+        const ARMJIT::Statistics& jit = nds->JIT.Stats;
+        printf("jit blocks:  %llu compiled  %llu restored  %llu invalidated  %llu evicted\n",
+               (unsigned long long)jit.BlocksCompiled, (unsigned long long)jit.BlocksRestored,
+               (unsigned long long)jit.BlocksInvalidated, (unsigned long long)jit.BlocksEvicted);
+    }
+#endif
+
+    if (opt.ResampleRate)
+    {
+        printf("resampler:   %llu frames at %u Hz in %.1f ms (%.1f ns per frame)\n",
+               (unsigned long long)resampledFrames, opt.ResampleRate, resampleMs,
+               resampledFrames ? resampleMs * 1e6 / resampledFrames : 0.0);
+        printf("spu output:  %llu frames overrun, %llu frames underrun\n",
+               (unsigned long long)nds->SPU.GetOutputOverruns(),
+               (unsigned long long)nds->SPU.GetOutputUnderruns());
+    }
+
+    if (rewind)
+    {
+        u32 snapshots = rewind->NumSnapshots();
+        u64 used = rewind->MemoryUsed();
+        printf("rewind:      %u snapshots (%.1f s of play) in %.2f MB\n",
+               snapshots, snapshots * opt.RewindInterval / 59.8261, used / 1048576.0);
+
+        // step all the way back, as holding the rewind key would
+        auto t0 = clock::now();
+        u32 loaded = 0;
+        while (rewind->Rewind(*nds)) loaded++;
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+        printf("             stepped back through %u in %.1f ms (%.3f ms each)\n",
+               loaded, ms, loaded ? ms / loaded : 0.0);
+    }
+
+#ifdef FRAME_PROFILER_ENABLED
+    if (opt.Profile)
+        printf("\n%s", nds->Profiler.Report().c_str());
+#endif
+
+    if (compareLog)
+    {
+        if (mismatch >= 0)
+        {
+            printf("compare:     differs from %s from frame %d on\n", opt.ComparePath.c_str(), mismatch);
+            return 1;
+        }
+        printf("compare:     all %d frames match %s\n", frameNum, opt.ComparePath.c_str());
+    }
+
+    return 0;
+}
@@ -55,8 +55,11 @@ DefaultList<int> DefaultInts =
     {"Screen.VSyncInterval", 1},
     {"3D.Renderer", renderer3D_Software},
     {"3D.GL.ScaleFactor", 1},
+    {"3D.Soft.RasterThreads", 1},
 #ifdef JIT_ENABLED
     {"JIT.MaxBlockSize", 32},
+    {"JIT.CompileThreshold", 1},
+    {"JIT.CompileBudget", 0},
 #endif
     {"Instance*.Firmware.Language", 1},
     {"Instance*.Firmware.BirthdayMonth", 1},
@@ -64,6 +67,7 @@ DefaultList<int> DefaultInts =
     {"MP.AudioMode", 1},
     {"MP.RecvTimeout", 25},
     {"Instance*.Audio.Volume", 256},
+    {"Audio.Latency", 1},
     {"Mic.InputType", 1},
     {"Mouse.HideSeconds", 5},
     {"Instance*.DSi.Battery.Level", 0xF},
@@ -72,6 +76,9 @@ DefaultList<int> DefaultInts =
     {"Instance*.Gdb.ARM9.Port", 3333},
 #endif
     {"LAN.HostNumPlayers", 16},
+    {"TexReplace.BudgetMB", 1024},
+    {"Rewind.Interval", 6},
+    {"Rewind.BudgetMB", 64},
 };
 
 RangeList IntRanges =
@@ -80,8 +87,10 @@ RangeList IntRanges =
     {"3D.Renderer", {0, renderer3D_Max-1}},
     {"Screen.VSyncInterval", {1, 20}},
     {"3D.GL.ScaleFactor", {1, 16}},
+    {"3D.Soft.RasterThreads", {1, 16}},
     {"Audio.Interpolation", {0, 4}},
     {"Instance*.Audio.Volume", {0, 256}},
+    {"Audio.Latency", {1, 3}},
     {"Mic.InputType", {0, micInputType_MAX-1}},
     {"Instance*.Window*.ScreenRotation", {0, screenRot_MAX-1}},
     {"Instance*.Window*.ScreenGap", {0, 500}},
@@ -91,6 +100,13 @@ RangeList IntRanges =
     {"Instance*.Window*.ScreenAspectBot", {0, AspectRatiosNum-1}},
     {"MP.AudioMode", {0, 2}},
     {"LAN.HostNumPlayers", {2, 16}},
+    {"TexReplace.BudgetMB", {64, 65536}},
+    {"Rewind.Interval", {1, 600}},
+    {"Rewind.BudgetMB", {16, 4096}},
+#ifdef JIT_ENABLED
+    {"JIT.CompileThreshold", {1, 1000}},
+    {"JIT.CompileBudget", {0, 100000}},
+#endif
 };
 
 DefaultList<bool> DefaultBools =
@@ -106,6 +122,8 @@ DefaultList<bool> DefaultBools =
 #ifdef JIT_ENABLED
     {"JIT.BranchOptimisations", true},
     {"JIT.LiteralOptimisations", true},
+    {"JIT.BlockCache", false},
+    {"JIT.BackgroundCompile", false},
 #ifndef __APPLE__
     {"JIT.FastMemory", true},
 #endif
@@ -29,6 +29,7 @@
 #include <fstream>
 
 #include <QDateTime>
+#include <QFile>
 
 #include <zstd.h>
 #ifdef ARCHIVE_SUPPORT_ENABLED
@@ -46,6 +47,7 @@
 #include "RTC.h"
 #include "DSi_I2C.h"
 #include "FreeBIOS.h"
+#include "TexReplace.h"
 #include "main.h"
 
 using std::make_unique;
@@ -128,6 +130,11 @@ EmuInstance::EmuInstance(int inst) : deleting(false),
 
     net.RegisterInstance(instanceID);
 
+    stateWriter = std::make_unique<StateWriter>([this](const std::string& path, bool success)
+    {
+        stateWritten(path, success);
+    });
+
     emuThread = new EmuThread(this);
 
     numWindows = 0;
@@ -152,6 +159,9 @@ EmuInstance::EmuInstance(int inst) : deleting(false),
 
 EmuInstance::~EmuInstance()
 {
+    // let pending states reach the disk while there are still windows to report to
+    stateWriter->WaitIdle();
+
     deleting = true;
     deleteAllWindows();
 
@@ -159,6 +169,8 @@ EmuInstance::~EmuInstance()
     emuThread->wait();
     delete emuThread;
 
+    stateWriter = nullptr;
+
     net.UnregisterInstance(instanceID);
 
     audioDeInit();
@@ -167,6 +179,7 @@ EmuInstance::~EmuInstance()
     if (nds)
     {
         saveRTCData();
+        unloadJITCache();
         delete nds;
     }
 }
@@ -207,7 +220,9 @@ void EmuInstance::createWindow(int id)
     MainWindow* win = new MainWindow(id, this, mainWindow ? mainWindow : topWindow);
     if (!topWindow) topWindow = win;
     if (!mainWindow) mainWindow = win;
+    windowListLock.lock();
     windowList[id] = win;
+    windowListLock.unlock();
     numWindows++;
 
     emuThread->attachWindow(win);
@@ -235,7 +250,9 @@ void EmuInstance::deleteWindow(int id, bool close)
 
     emuThread->detachWindow(win);
 
+    windowListLock.lock();
     windowList[id] = nullptr;
+    windowListLock.unlock();
     numWindows--;
 
     if (topWindow == win) topWindow = nullptr;
@@ -331,11 +348,13 @@ void EmuInstance::osdAddMessage(unsigned int color, const char* fmt, ...)
     vsnprintf(msg, 256, fmt, args);
     va_end(args);
 
+    windowListLock.lock();
     for (int i = 0; i < kMaxWindows; i++)
     {
         if (windowList[i])
             windowList[i]->osdAddMessage(color, msg);
     }
+    windowListLock.unlock();
 }
 
 
@@ -707,55 +726,79 @@ bool EmuInstance::savestateExists(int slot)
 
 bool EmuInstance::loadState(const std::string& filename)
 {
-    Platform::FileHandle* file = Platform::OpenFile(filename, Platform::FileMode::Read);
-    if (file == nullptr)
+    // The state might still be on its way to disk
+    stateWriter->WaitIdle();
+
+    QFile file(QString::fromStdString(filename));
+    if (!file.open(QIODevice::ReadOnly))
     { // If we couldn't open the state file...
         Platform::Log(Platform::LogLevel::Error, "Failed to open state file \"%s\"\n", filename.c_str());
         return false;
     }
 
-    std::unique_ptr<Savestate> backup = std::make_unique<Savestate>(Savestate::DEFAULT_SIZE);
-    if (backup->Error)
+    // The backup goes into a spare buffer that is kept around between loads,
+    // so that it doesn't have to be allocated (and faulted in) every time.
+    // It only replaces the current backup once the new state has been loaded.
+    if (spareState)
+        spareState->Rewind(true);
+    else
+        spareState = std::make_unique<Savestate>(Savestate::DEFAULT_SIZE);
+
+    if (spareState->Error)
     { // If we couldn't allocate memory for the backup...
         Platform::Log(Platform::LogLevel::Error, "Failed to allocate memory for state backup\n");
-        Platform::CloseFile(file);
+        spareState = nullptr;
         return false;
     }
 
-    if (!nds->DoSavestate(backup.get()) || backup->Error)
+    if (!nds->DoSavestate(spareState.get()) || spareState->Error)
     { // Back up the emulator's state. If that failed...
         Platform::Log(Platform::LogLevel::Error, "Failed to back up state, aborting load (from \"%s\")\n", filename.c_str());
-        Platform::CloseFile(file);
         return false;
     }
-    // We'll store the backup once we're sure that the state was loaded.
     // Now that we know the file and backup are both good, let's load the new state.
 
-    // Get the size of the file that we opened
-    size_t size = Platform::FileLength(file);
-
-    // Allocate exactly as much memory as we need for the savestate
-    std::vector<u8> buffer(size);
-    if (Platform::FileRead(buffer.data(), size, 1, file) == 0)
-    { // Read the state file into the buffer. If that failed...
-        Platform::Log(Platform::LogLevel::Error, "Failed to read %u-byte state file \"%s\"\n", size, filename.c_str());
-        Platform::CloseFile(file);
+    // Map the file rather than reading it into a buffer, the state is loaded straight from the page cache.
+    // The mapping is private, so nothing the loader could write would end up in the file.
+    qint64 size = file.size();
+    uchar* data = file.map(0, size, QFileDevice::MapPrivateOption);
+    if (!data)
+    { // If the file couldn't be mapped...
+        Platform::Log(Platform::LogLevel::Error, "Failed to map %lld-byte state file \"%s\"\n", (long long)size, filename.c_str());
         return false;
     }
-    Platform::CloseFile(file); // done with the file now
 
-    // Get ready to load the state from the buffer into the emulator
-    std::unique_ptr<Savestate> state = std::make_unique<Savestate>(buffer.data(), size, false);
+    // States saved with Savestate.Compress are a single zstd frame
+    std::unique_ptr<u8[]> decompressed;
+    u32 statelen = (u32)size;
+    if (size >= 4 && (data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24)) == ZSTD_MAGICNUMBER)
+    {
+        statelen = decompressROM(data, (u32)size, decompressed);
+        file.unmap(data);
+        if (statelen == 0)
+        {
+            Platform::Log(Platform::LogLevel::Error, "Failed to decompress state file \"%s\"\n", filename.c_str());
+            return false;
+        }
 
-    if (!nds->DoSavestate(state.get()) || state->Error)
-    { // If we couldn't load the savestate from the buffer...
+        data = decompressed.get();
+    }
+
+    // Get ready to load the state into the emulator
+    Savestate state(data, statelen, false);
+    bool loaded = nds->DoSavestate(&state) && !state.Error;
+    if (!decompressed)
+        file.unmap(data);
+
+    if (!loaded)
+    { // If we couldn't load the savestate from the file...
         Platform::Log(Platform::LogLevel::Error, "Failed to load state file \"%s\" into emulator\n", filename.c_str());
         return false;
     }
 
     // The backup was made and the state was loaded, so we can store the backup now.
-    backupState = std::move(backup); // This will clean up any existing backup
-    assert(backup == nullptr);
+    // The previous backup becomes the spare buffer for next time.
+    std::swap(backupState, spareState);
 
     if (globalCfg.GetBool("Savestate.RelocSRAM") && ndsSave)
     {
@@ -774,41 +817,23 @@ bool EmuInstance::loadState(const std::string& filename)
 
 bool EmuInstance::saveState(const std::string& filename)
 {
-    Platform::FileHandle* file = Platform::OpenFile(filename, Platform::FileMode::Write);
-
-    if (file == nullptr)
-    { // If the file couldn't be opened...
-        return false;
-    }
-
-    Savestate state;
-    if (state.Error)
+    auto state = std::make_unique<Savestate>();
+    if (state->Error)
     { // If there was an error creating the state (and allocating its memory)...
-        Platform::CloseFile(file);
         return false;
     }
 
     // Write the savestate to the in-memory buffer
-    nds->DoSavestate(&state);
+    nds->DoSavestate(state.get());
 
-    if (state.Error)
+    if (state->Error)
     {
-        Platform::CloseFile(file);
         return false;
     }
 
-    if (Platform::FileWrite(state.Buffer(), state.Length(), 1, file) == 0)
-    { // Write the Savestate buffer to the file. If that fails...
-        Platform::Log(Platform::Error,
-                      "Failed to write %d-byte savestate to %s\n",
-                      state.Length(),
-                      filename.c_str()
-        );
-        Platform::CloseFile(file);
-        return false;
-    }
-
-    Platform::CloseFile(file);
+    // The buffer is a complete snapshot by now, so writing it out doesn't have
+    // to hold up emulation. The writer reports back through stateWritten().
+    stateWriter->Queue(std::move(state), filename, globalCfg.GetBool("Savestate.Compress"));
 
     if (globalCfg.GetBool("Savestate.RelocSRAM") && ndsSave)
     {
@@ -821,6 +846,30 @@ bool EmuInstance::saveState(const std::string& filename)
     return true;
 }
 
+void EmuInstance::stateWritten(const std::string& filename, bool success)
+{
+    // called from the writer thread, osdAddMessage() locks the window list
+    if (deleting) return;
+
+    // slot files are named <ROM>.ml1 to <ROM>.ml8, see getSavestateName()
+    int slot = 0;
+    size_t len = filename.length();
+    if (len > 4 && filename.compare(len - 4, 3, ".ml") == 0 &&
+        filename[len - 1] >= '1' && filename[len - 1] <= '8')
+        slot = filename[len - 1] - '0';
+
+    if (success)
+    {
+        if (slot > 0) osdAddMessage(0, "State saved to slot %d", slot);
+        else          osdAddMessage(0, "State saved to file");
+    }
+    else
+    {
+        if (slot > 0) osdAddMessage(0xFFA0A0, "State save to slot %d failed", slot);
+        else          osdAddMessage(0xFFA0A0, "State save failed");
+    }
+}
+
 void EmuInstance::undoStateLoad()
 {
     if (!savestateLoaded || !backupState) return;
@@ -864,6 +913,48 @@ void EmuInstance::loadCheats()
     }
 }
 
+void EmuInstance::unloadJITCache()
+{
+#ifdef JIT_ENABLED
+    if (nds && !jitCacheFile.empty())
+        nds->JIT.SavePersistentCache(jitCacheFile);
+#endif
+    jitCacheFile = "";
+}
+
+void EmuInstance::loadJITCache()
+{
+    unloadJITCache();
+
+#ifdef JIT_ENABLED
+    if (!nds || !globalCfg.GetBool("JIT.Enable") || !globalCfg.GetBool("JIT.BlockCache"))
+        return;
+
+    jitCacheFile = getAssetPath(false, localCfg.GetString("SaveFilePath"), ".mjc");
+    nds->JIT.LoadPersistentCache(jitCacheFile);
+#endif
+}
+
+void EmuInstance::resetRewind()
+{
+    if (!nds || !globalCfg.GetBool("Rewind.Enable"))
+    {
+        rewindBuffer = nullptr;
+        return;
+    }
+
+    u32 interval = globalCfg.GetInt("Rewind.Interval");
+    u64 budget = (u64)globalCfg.GetInt("Rewind.BudgetMB") << 20;
+    if (rewindBuffer)
+    {
+        rewindBuffer->SetInterval(interval);
+        rewindBuffer->SetBudget(budget);
+        rewindBuffer->Clear();
+    }
+    else
+        rewindBuffer = std::make_unique<RewindBuffer>(interval, budget);
+}
+
 std::unique_ptr<ARM9BIOSImage> EmuInstance::loadARM9BIOS() noexcept
 {
     if (!globalCfg.GetBool("Emu.ExternalBIOSEnable"))
@@ -1292,6 +1383,9 @@ bool EmuInstance::updateConsole() noexcept
             jitopt.GetBool("LiteralOptimisations"),
             jitopt.GetBool("BranchOptimisations"),
             jitopt.GetBool("FastMemory"),
+            static_cast<unsigned>(jitopt.GetInt("CompileThreshold")),
+            static_cast<unsigned>(jitopt.GetInt("CompileBudget")),
+            jitopt.GetBool("BackgroundCompile"),
     };
     auto jitargs = jitopt.GetBool("Enable") ? std::make_optional(_jitargs) : std::nullopt;
 #else
@@ -1358,6 +1452,8 @@ bool EmuInstance::updateConsole() noexcept
         if (nds)
         {
             saveRTCData();
+            unloadJITCache();
+            rewindBuffer = nullptr;
             delete nds;
         }
 
@@ -1468,6 +1564,7 @@ void EmuInstance::reset()
         }
     }
 
+    resetRewind();
     nds->Start();
 }
 
@@ -1493,6 +1590,7 @@ bool EmuInstance::bootToMenu(QString& errorstr)
     nds->Reset();
     setBatteryLevels();
     setDateTime();
+    resetRewind();
     return true;
 }
 
@@ -1588,6 +1686,8 @@ void EmuInstance::clearBackupState()
     {
         backupState = nullptr;
     }
+
+    spareState = nullptr;
 }
 
 pair<unique_ptr<Firmware>, string> EmuInstance::generateDefaultFirmware()
@@ -1873,6 +1973,7 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset, QString& errorstr)
         return false;
     }
 
+    unloadJITCache();
     ndsSave = nullptr;
 
     baseROMDir = basepath;
@@ -1969,11 +2070,22 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset, QString& errorstr)
     cartType = 0;
     ndsSave = std::make_unique<SaveManager>(savname);
 
+    // replacements are keyed per game, drop whatever the previous ROM loaded
+    ClearAllReplacements();
+    TexReplace_SetMemoryBudget((size_t)globalCfg.GetInt("TexReplace.BudgetMB") << 20);
+    if (TexReplace_ReplaceEnabled() && TexReplace_PrewarmEnabled())
+        TexReplace_PrewarmAll();
+
+    loadJITCache();
+    resetRewind();
+
     return true; // success
 }
 
 void EmuInstance::ejectCart()
 {
+    unloadJITCache();
+    rewindBuffer = nullptr;
     ndsSave = nullptr;
 
     if (emuIsActive())
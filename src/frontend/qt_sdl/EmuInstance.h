@@ -24,10 +24,13 @@
 #include "Platform.h"
 #include "main.h"
 #include "NDS.h"
+#include "RewindBuffer.h"
 #include "EmuThread.h"
 #include "Window.h"
 #include "Config.h"
 #include "SaveManager.h"
+#include "StateWriter.h"
+#include "AudioResampler.h"
 
 const int kMaxWindows = 4;
 
@@ -55,6 +58,7 @@ enum
     HK_GuitarGripRed,
     HK_GuitarGripYellow,
     HK_GuitarGripBlue,
+    HK_Rewind,
     HK_MAX
 };
 
@@ -177,9 +181,13 @@ private:
     bool savestateExists(int slot);
     bool loadState(const std::string& filename);
     bool saveState(const std::string& filename);
+    void stateWritten(const std::string& filename, bool success);
     void undoStateLoad();
     void unloadCheats();
     void loadCheats();
+    void unloadJITCache();
+    void loadJITCache();
+    void resetRewind();
     std::unique_ptr<melonDS::ARM9BIOSImage> loadARM9BIOS() noexcept;
     std::unique_ptr<melonDS::ARM7BIOSImage> loadARM7BIOS() noexcept;
     std::unique_ptr<melonDS::DSiBIOSImage> loadDSiARM9BIOS() noexcept;
@@ -226,9 +234,6 @@ private:
     void micProcess();
     void setupMicInputData();
 
-    int audioGetNumSamplesOut(int outlen);
-    void audioResample(melonDS::s16* inbuf, int inlen, melonDS::s16* outbuf, int outlen, int volume);
-
     static void audioCallback(void* data, Uint8* stream, int len);
     static void micCallback(void* data, Uint8* stream, int len);
 
@@ -258,6 +263,9 @@ private:
 
     MainWindow* mainWindow;
     MainWindow* windowList[kMaxWindows];
+    // osdAddMessage() can be called from other threads (the emu thread, the state writer)
+    // while windows are created or closed
+    QMutex windowListLock;
     int numWindows;
 
     Config::Table globalCfg;
@@ -297,19 +305,25 @@ public:
 private:
 
     std::unique_ptr<melonDS::Savestate> backupState;
+    std::unique_ptr<melonDS::Savestate> spareState;
+    std::unique_ptr<StateWriter> stateWriter;
     bool savestateLoaded;
     std::string previousSaveFile;
 
     std::unique_ptr<melonDS::ARCodeFile> cheatFile;
     bool cheatsOn;
 
+    std::string jitCacheFile;
+
+    std::unique_ptr<melonDS::RewindBuffer> rewindBuffer;
+
     SDL_AudioDeviceID audioDevice;
     int audioFreq;
     int audioBufSize;
-    float audioSampleFrac;
+    AudioResampler audioResampler;
     bool audioMuted;
-    SDL_cond* audioSyncCond;
-    SDL_mutex* audioSyncLock;
+    int audioLatency;
+    SDL_sem* audioSyncSem;
 
     int mpAudioMode;
 
@@ -27,60 +27,24 @@
 using namespace melonDS;
 
 
-int EmuInstance::audioGetNumSamplesOut(int outlen)
-{
-    float f_len_in = (outlen * 32823.6328125 * (curFPS/60.0)) / (float)audioFreq;
-    f_len_in += audioSampleFrac;
-    int len_in = (int)floor(f_len_in);
-    audioSampleFrac = f_len_in - len_in;
-
-    return len_in;
-}
-
-void EmuInstance::audioResample(s16* inbuf, int inlen, s16* outbuf, int outlen, int volume)
-{
-    float res_incr = inlen / (float)outlen;
-    float res_timer = -0.5;
-    int res_pos = 0;
-
-    for (int i = 0; i < outlen; i++)
-    {
-        s16 l1 = inbuf[res_pos * 2];
-        s16 l2 = inbuf[res_pos * 2 + 2];
-        s16 r1 = inbuf[res_pos * 2 + 1];
-        s16 r2 = inbuf[res_pos * 2 + 3];
-
-        float l = (float) l1 + ((l2 - l1) * res_timer);
-        float r = (float) r1 + ((r2 - r1) * res_timer);
-
-        outbuf[i*2  ] = (s16) (((s32) round(l) * volume) >> 8);
-        outbuf[i*2+1] = (s16) (((s32) round(r) * volume) >> 8);
-
-        res_timer += res_incr;
-        while (res_timer >= 1.0)
-        {
-            res_timer -= 1.0;
-            res_pos++;
-        }
-    }
-}
-
 void EmuInstance::audioCallback(void* data, Uint8* stream, int len)
 {
     EmuInstance* inst = (EmuInstance*)data;
     len /= (sizeof(s16) * 2);
 
     // resample incoming audio to match the output sample rate
+    // the ratio is nudged so the SPU buffer stays around half the allowed latency
 
-    int len_in = inst->audioGetNumSamplesOut(len);
+    inst->audioResampler.SetInputRate(32823.6328125 * (inst->curFPS/60.0));
+    int len_in = inst->audioResampler.InputFramesNeeded(len);
     if (len_in > inst->audioBufSize) len_in = inst->audioBufSize;
     s16 buf_in[inst->audioBufSize*2];
-    int num_in;
+    int num_in, num_left;
 
-    SDL_LockMutex(inst->audioSyncLock);
+    // the SPU output buffer is lock-free, nothing here can hold up the emulator
     num_in = inst->nds->SPU.ReadOutput(buf_in, len_in);
-    SDL_CondSignal(inst->audioSyncCond);
-    SDL_UnlockMutex(inst->audioSyncLock);
+    num_left = inst->nds->SPU.GetOutputSize();
+    SDL_SemPost(inst->audioSyncSem);
 
     if ((num_in < 1) || inst->audioMuted)
     {
@@ -88,18 +52,8 @@ void EmuInstance::audioCallback(void* data, Uint8* stream, int len)
         return;
     }
 
-    int margin = 6;
-    if (num_in < len_in-margin)
-    {
-        int last = num_in-1;
-
-        for (int i = num_in; i < len_in-margin; i++)
-            ((u32*)buf_in)[i] = ((u32*)buf_in)[last];
-
-        num_in = len_in-margin;
-    }
-
-    inst->audioResample(buf_in, num_in, (s16*)stream, len, inst->audioVolume);
+    inst->audioResampler.UpdateFillLevel(num_left, inst->audioLatency / 2);
+    inst->audioResampler.Process(buf_in, num_in, (s16*)stream, len, inst->audioVolume);
 }
 
 void EmuInstance::micCallback(void* data, Uint8* stream, int len)
@@ -413,8 +367,7 @@ void EmuInstance::audioInit()
     audioDSiVolumeSync = localCfg.GetBool("Audio.DSiVolumeSync");
 
     audioMuted = false;
-    audioSyncCond = SDL_CreateCond();
-    audioSyncLock = SDL_CreateMutex();
+    audioSyncSem = SDL_CreateSemaphore(0);
 
     audioFreq = 48000; // TODO: make both of these configurable?
     audioBufSize = 1024;
@@ -440,7 +393,12 @@ void EmuInstance::audioInit()
         SDL_PauseAudioDevice(audioDevice, 1);
     }
 
-    audioSampleFrac = 0;
+    // how much audio the emulator may queue ahead of the device, in device periods
+    audioLatency = audioBufSize * globalCfg.GetInt("Audio.Latency");
+    if (audioLatency > (int)SPU::OutputBufferSize - audioBufSize)
+        audioLatency = (int)SPU::OutputBufferSize - audioBufSize;
+
+    audioResampler.Setup(32823.6328125, audioFreq, audioBufSize);
 
     micDevice = 0;
 
@@ -464,11 +422,8 @@ void EmuInstance::audioDeInit()
     audioDevice = 0;
     micClose();
 
-    if (audioSyncCond) SDL_DestroyCond(audioSyncCond);
-    audioSyncCond = nullptr;
-
-    if (audioSyncLock) SDL_DestroyMutex(audioSyncLock);
-    audioSyncLock = nullptr;
+    if (audioSyncSem) SDL_DestroySemaphore(audioSyncSem);
+    audioSyncSem = nullptr;
 
     if (micWavBuffer) delete[] micWavBuffer;
     micWavBuffer = nullptr;
@@ -481,13 +436,14 @@ void EmuInstance::audioSync()
 {
     if (audioDevice)
     {
-        SDL_LockMutex(audioSyncLock);
-        while (nds->SPU.GetOutputSize() > audioBufSize)
+        // the audio callback posts once per period, forget the ones nobody waited for
+        while (SDL_SemTryWait(audioSyncSem) == 0);
+
+        while (nds->SPU.GetOutputSize() > audioLatency)
         {
-            int ret = SDL_CondWaitTimeout(audioSyncCond, audioSyncLock, 500);
+            int ret = SDL_SemWaitTimeout(audioSyncSem, 500);
             if (ret == SDL_MUTEX_TIMEDOUT) break;
         }
-        SDL_UnlockMutex(audioSyncLock);
     }
 }
 
@@ -40,6 +40,7 @@
 #include "NDSCart.h"
 #include "GBACart.h"
 #include "GPU.h"
+#include "GPU2D_Soft.h"
 #include "SPU.h"
 #include "Wifi.h"
 #include "Platform.h"
@@ -298,6 +299,12 @@ void EmuThread::run()
             }
 
 
+            // while the rewind hotkey is held, step back one snapshot per frame
+            // instead of recording new ones
+            bool rewinding = false;
+            if (emuInstance->rewindBuffer && emuInstance->hotkeyDown(HK_Rewind))
+                rewinding = emuInstance->rewindBuffer->Rewind(*emuInstance->nds);
+
             // emulate
             u32 nlines;
             if (emuInstance->nds->GPU.GetRenderer3D().NeedsShaderCompile())
@@ -308,6 +315,9 @@ void EmuThread::run()
             else
             {
                 nlines = emuInstance->nds->RunFrame();
+
+                if (emuInstance->rewindBuffer && !rewinding)
+                    emuInstance->rewindBuffer->Frame(*emuInstance->nds);
             }
 
             if (emuInstance->ndsSave)
@@ -885,12 +895,18 @@ void EmuThread::updateRenderer()
     lastVideoRenderer = videoRenderer;
 
     auto& cfg = emuInstance->getGlobalConfig();
+    static_cast<GPU2D::SoftRenderer&>(emuInstance->nds->GPU.GetRenderer2D()).SetThreaded(
+            cfg.GetBool("2D.Soft.Threaded"));
+
     switch (videoRenderer)
     {
         case renderer3D_Software:
             static_cast<SoftRenderer&>(emuInstance->nds->GPU.GetRenderer3D()).SetThreaded(
                     cfg.GetBool("3D.Soft.Threaded"),
                     emuInstance->nds->GPU);
+            static_cast<SoftRenderer&>(emuInstance->nds->GPU.GetRenderer3D()).SetRasterThreads(
+                    cfg.GetInt("3D.Soft.RasterThreads"),
+                    emuInstance->nds->GPU);
             break;
         case renderer3D_OpenGL:
             static_cast<GLRenderer&>(emuInstance->nds->GPU.GetRenderer3D()).SetRenderSettings(
@@ -59,6 +59,7 @@ static constexpr std::initializer_list<int> hk_general =
     HK_FastForwardToggle,
     HK_SlowMo,
     HK_SlowMoToggle,
+    HK_Rewind,
     HK_FrameLimitToggle,
     HK_FullscreenToggle,
     HK_Lid,
@@ -79,6 +80,7 @@ static constexpr std::initializer_list<const char*> hk_general_labels =
     "Toggle fast forward",
     "Slow mo",
     "Toggle slow mo",
+    "Rewind",
     "Toggle FPS limit",
     "Toggle fullscreen",
     "Close/open lid",
@@ -0,0 +1,136 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <QSaveFile>
+#include <zstd.h>
+
+#include "StateWriter.h"
+#include "Platform.h"
+
+using namespace melonDS;
+using namespace melonDS::Platform;
+
+StateWriter::StateWriter(Callback onWritten) : QThread()
+{
+    OnWritten = std::move(onWritten);
+
+    Busy = false;
+    Running = true;
+    start();
+}
+
+StateWriter::~StateWriter()
+{
+    // don't drop states the user asked for
+    WaitIdle();
+
+    Lock.lock();
+    Running = false;
+    WorkCond.wakeAll();
+    Lock.unlock();
+
+    wait();
+}
+
+void StateWriter::Queue(std::unique_ptr<Savestate> state, const std::string& path, bool compress)
+{
+    Lock.lock();
+    Jobs.push_back({std::move(state), path, compress});
+    WorkCond.wakeAll();
+    Lock.unlock();
+}
+
+void StateWriter::WaitIdle()
+{
+    Lock.lock();
+    while (Busy || !Jobs.empty())
+        IdleCond.wait(&Lock);
+    Lock.unlock();
+}
+
+void StateWriter::run()
+{
+    for (;;)
+    {
+        Lock.lock();
+        while (Running && Jobs.empty())
+            WorkCond.wait(&Lock);
+
+        if (Jobs.empty())
+        { // Only reached when stopping, once everything has been written
+            Lock.unlock();
+            return;
+        }
+
+        Job job = std::move(Jobs.front());
+        Jobs.pop_front();
+        Busy = true;
+        Lock.unlock();
+
+        bool success = Write(job);
+        job.State = nullptr;
+
+        if (OnWritten)
+            OnWritten(job.Path, success);
+
+        Lock.lock();
+        Busy = false;
+        IdleCond.wakeAll();
+        Lock.unlock();
+    }
+}
+
+bool StateWriter::Write(const Job& job)
+{
+    const char* data = static_cast<const char*>(job.State->Buffer());
+    size_t len = job.State->Length();
+
+    std::unique_ptr<char[]> compressed;
+    if (job.Compress)
+    { // Wrap the state in a zstd frame, which loadState recognises by its magic number
+        size_t bound = ZSTD_compressBound(len);
+        compressed = std::make_unique<char[]>(bound);
+
+        size_t clen = ZSTD_compress(compressed.get(), bound, data, len, 1);
+        if (ZSTD_isError(clen))
+        {
+            Log(LogLevel::Error, "StateWriter: failed to compress state for %s: %s\n", job.Path.c_str(), ZSTD_getErrorName(clen));
+            return false;
+        }
+
+        data = compressed.get();
+        len = clen;
+    }
+
+    // QSaveFile writes to a temporary file and renames it over the target on commit
+    QSaveFile file(QString::fromStdString(job.Path));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        Log(LogLevel::Error, "StateWriter: failed to open %s for writing\n", job.Path.c_str());
+        return false;
+    }
+
+    if (file.write(data, len) != (qint64)len || !file.commit())
+    {
+        Log(LogLevel::Error, "StateWriter: failed to write %zu-byte state to %s\n", len, job.Path.c_str());
+        return false;
+    }
+
+    Log(LogLevel::Info, "StateWriter: wrote %zu bytes to %s\n", len, job.Path.c_str());
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef STATEWRITER_H
+#define STATEWRITER_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "Savestate.h"
+
+// Writes serialised savestates to disk off the emulation thread.
+// Each state is written to a temporary file that replaces the target once
+// it is complete, so a crash or a full disk never leaves a truncated state.
+class StateWriter : public QThread
+{
+    Q_OBJECT
+    void run() override;
+
+public:
+    // called on the writer thread once a state has been written (or not)
+    using Callback = std::function<void(const std::string& path, bool success)>;
+
+    explicit StateWriter(Callback onWritten);
+    ~StateWriter();
+
+    // takes ownership of the state, which must be finished
+    void Queue(std::unique_ptr<melonDS::Savestate> state, const std::string& path, bool compress);
+
+    // blocks until every queued state has been written
+    void WaitIdle();
+
+private:
+    struct Job
+    {
+        std::unique_ptr<melonDS::Savestate> State;
+        std::string Path;
+        bool Compress;
+    };
+
+    bool Write(const Job& job);
+
+    Callback OnWritten;
+
+    QMutex Lock;
+    QWaitCondition WorkCond;
+    QWaitCondition IdleCond;
+    std::deque<Job> Jobs;
+    bool Busy;
+    bool Running;
+};
+
+#endif // STATEWRITER_H
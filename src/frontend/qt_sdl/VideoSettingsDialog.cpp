@@ -45,6 +45,7 @@ void VideoSettingsDialog::setEnabled()
     bool softwareRenderer = renderer == renderer3D_Software;
     ui->cbGLDisplay->setEnabled(softwareRenderer);
     ui->cbSoftwareThreaded->setEnabled(softwareRenderer);
+    ui->sbSoftwareRasterThreads->setEnabled(softwareRenderer);
     ui->cbxGLResolution->setEnabled(!softwareRenderer);
     ui->cbBetterPolygons->setEnabled(renderer == renderer3D_OpenGL);
     ui->cbxComputeHiResCoords->setEnabled(renderer == renderer3D_OpenGLCompute);
@@ -63,6 +64,7 @@ VideoSettingsDialog::VideoSettingsDialog(QWidget* parent) : QDialog(parent), ui(
     oldVSync = cfg.GetBool("Screen.VSync");
     oldVSyncInterval = cfg.GetInt("Screen.VSyncInterval");
     oldSoftThreaded = cfg.GetBool("3D.Soft.Threaded");
+    oldSoftRasterThreads = cfg.GetInt("3D.Soft.RasterThreads");
     oldGLScale = cfg.GetInt("3D.GL.ScaleFactor");
     oldGLBetterPolygons = cfg.GetBool("3D.GL.BetterPolygons");
     oldHiresCoordinates = cfg.GetBool("3D.GL.HiresCoordinates");
@@ -92,6 +94,7 @@ VideoSettingsDialog::VideoSettingsDialog(QWidget* parent) : QDialog(parent), ui(
     ui->sbVSyncInterval->setValue(oldVSyncInterval);
 
     ui->cbSoftwareThreaded->setChecked(oldSoftThreaded);
+    ui->sbSoftwareRasterThreads->setValue(oldSoftRasterThreads);
 
     for (int i = 1; i <= 16; i++)
         ui->cbxGLResolution->addItem(QString("%1x native (%2x%3)").arg(i).arg(256*i).arg(192*i));
@@ -135,6 +138,7 @@ void VideoSettingsDialog::on_VideoSettingsDialog_rejected()
     cfg.SetBool("Screen.VSync", oldVSync);
     cfg.SetInt("Screen.VSyncInterval", oldVSyncInterval);
     cfg.SetBool("3D.Soft.Threaded", oldSoftThreaded);
+    cfg.SetInt("3D.Soft.RasterThreads", oldSoftRasterThreads);
     cfg.SetInt("3D.GL.ScaleFactor", oldGLScale);
     cfg.SetBool("3D.GL.BetterPolygons", oldGLBetterPolygons);
     cfg.SetBool("3D.GL.HiresCoordinates", oldHiresCoordinates);
@@ -201,6 +205,14 @@ void VideoSettingsDialog::on_cbSoftwareThreaded_stateChanged(int state)
     emit updateVideoSettings(false);
 }
 
+void VideoSettingsDialog::on_sbSoftwareRasterThreads_valueChanged(int val)
+{
+    auto& cfg = emuInstance->getGlobalConfig();
+    cfg.SetInt("3D.Soft.RasterThreads", val);
+
+    emit updateVideoSettings(false);
+}
+
 void VideoSettingsDialog::on_cbxGLResolution_currentIndexChanged(int idx)
 {
     // prevent a spurious change
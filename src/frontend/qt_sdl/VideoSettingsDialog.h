@@ -71,6 +71,7 @@ private slots:
     void on_cbxComputeHiResCoords_stateChanged(int state);
 
     void on_cbSoftwareThreaded_stateChanged(int state);
+    void on_sbSoftwareRasterThreads_valueChanged(int val);
 private:
     void setVsyncControlEnable(bool hasOGL);
     void setEnabled();
@@ -85,6 +86,7 @@ private:
     int oldVSync;
     int oldVSyncInterval;
     int oldSoftThreaded;
+    int oldSoftRasterThreads;
     int oldGLScale;
     int oldGLBetterPolygons;
     int oldHiresCoordinates;
@@ -662,6 +662,10 @@ MainWindow::MainWindow(int id, EmuInstance* inst, QWidget* parent) :
                 actSavestateSRAMReloc = submenu->addAction("Separate savefiles");
                 actSavestateSRAMReloc->setCheckable(true);
                 connect(actSavestateSRAMReloc, &QAction::triggered, this, &MainWindow::onChangeSavestateSRAMReloc);
+
+                actSavestateCompress = submenu->addAction("Compress savestates");
+                actSavestateCompress->setCheckable(true);
+                connect(actSavestateCompress, &QAction::triggered, this, &MainWindow::onChangeSavestateCompress);
             }
 
             menu->addSeparator();
@@ -681,9 +685,22 @@ MainWindow::MainWindow(int id, EmuInstance* inst, QWidget* parent) :
                 actDumpTextures->setCheckable(true);
                 connect(actDumpTextures, &QAction::toggled, this, &MainWindow::onDumpChange);
 
+                actDumpPackTextures = submenu->addAction("Dump into a single pack file");
+                actDumpPackTextures->setCheckable(true);
+                connect(actDumpPackTextures, &QAction::toggled, this, &MainWindow::onDumpPackChange);
+
                 actRestoreTextures = submenu->addAction("Mod");
                 actRestoreTextures->setCheckable(true);
                 connect(actRestoreTextures, &QAction::toggled, this, &MainWindow::onRestoreChange);
+
+                actPrewarmTextures = submenu->addAction("Preload mods on ROM load");
+                actPrewarmTextures->setCheckable(true);
+                connect(actPrewarmTextures, &QAction::toggled, this, &MainWindow::onPrewarmChange);
+
+                // one-off tool, deliberately not saved to the config
+                actMigrateTextures = submenu->addAction("Migrate old pack file names");
+                actMigrateTextures->setCheckable(true);
+                connect(actMigrateTextures, &QAction::toggled, this, &MainWindow::onMigrateChange);
             }
         }
         {
@@ -762,8 +779,11 @@ MainWindow::MainWindow(int id, EmuInstance* inst, QWidget* parent) :
         actRAMInfo->setEnabled(false);
 
         actSavestateSRAMReloc->setChecked(globalCfg.GetBool("Savestate.RelocSRAM"));
+        actSavestateCompress->setChecked(globalCfg.GetBool("Savestate.Compress"));
         actDumpTextures->setChecked(globalCfg.GetBool("TexReplace.Dump"));
         actRestoreTextures->setChecked(globalCfg.GetBool("TexReplace.Replace"));
+        actDumpPackTextures->setChecked(globalCfg.GetBool("TexReplace.DumpPack"));
+        actPrewarmTextures->setChecked(globalCfg.GetBool("TexReplace.Prewarm"));
 
         actScreenRotation[windowCfg.GetInt("ScreenRotation")]->setChecked(true);
 
@@ -1606,9 +1626,7 @@ void MainWindow::onSaveState()
 
     if (emuThread->saveState(filename))
     {
-        if (slot > 0) emuInstance->osdAddMessage(0, "State saved to slot %d", slot);
-        else          emuInstance->osdAddMessage(0, "State saved to file");
-
+        // the state is written in the background, EmuInstance reports when it's done
         actLoadState[slot]->setEnabled(true);
     }
     else
@@ -2072,18 +2090,40 @@ void MainWindow::onChangeSavestateSRAMReloc(bool checked)
     globalCfg.SetBool("Savestate.RelocSRAM", checked);
 }
 
+void MainWindow::onChangeSavestateCompress(bool checked)
+{
+    globalCfg.SetBool("Savestate.Compress", checked);
+}
+
 void MainWindow::onDumpChange(bool checked)
 {
     melonDS::TexReplace_SetDump(checked);
     globalCfg.SetBool("TexReplace.Dump", checked);
 }
 
+void MainWindow::onDumpPackChange(bool checked)
+{
+    melonDS::TexReplace_SetDumpPack(checked);
+    globalCfg.SetBool("TexReplace.DumpPack", checked);
+}
+
 void MainWindow::onRestoreChange(bool checked)
 {
     melonDS::TexReplace_SetReplace(checked);
     globalCfg.SetBool("TexReplace.Replace", checked);
 }
 
+void MainWindow::onMigrateChange(bool checked)
+{
+    melonDS::TexReplace_SetMigrate(checked);
+}
+
+void MainWindow::onPrewarmChange(bool checked)
+{
+    melonDS::TexReplace_SetPrewarm(checked);
+    globalCfg.SetBool("TexReplace.Prewarm", checked);
+}
+
 void MainWindow::onChangeScreenSize()
 {
     int factor = ((QAction*)sender())->data().toInt();
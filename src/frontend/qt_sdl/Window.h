@@ -215,6 +215,7 @@ private slots:
     void onInterfaceSettingsFinished(int res);
     void onUpdateInterfaceSettings();
     void onChangeSavestateSRAMReloc(bool checked);
+    void onChangeSavestateCompress(bool checked);
     void onChangeScreenSize();
     void onChangeScreenRotation(QAction* act);
     void onChangeScreenGap(QAction* act);
@@ -229,7 +230,10 @@ private slots:
     void onChangeLimitFramerate(bool checked);
     void onChangeAudioSync(bool checked);
     void onDumpChange(bool checked);
+    void onDumpPackChange(bool checked);
     void onRestoreChange(bool checked);
+    void onPrewarmChange(bool checked);
+    void onMigrateChange(bool checked);
 
     void onTitleUpdate(QString title);
 
@@ -333,8 +337,12 @@ public:
     QAction* actPathSettings;
     QAction* actInterfaceSettings;
     QAction* actSavestateSRAMReloc;
+    QAction* actSavestateCompress;
     QAction* actDumpTextures;
+    QAction* actDumpPackTextures;
     QAction* actRestoreTextures;
+    QAction* actPrewarmTextures;
+    QAction* actMigrateTextures;
     QAction* actScreenSize[4];
     QActionGroup* grpScreenRotation;
     QAction* actScreenRotation[screenRot_MAX];